@@ -0,0 +1,16 @@
+#version 300 es
+precision mediump float;
+
+in vec3 fNormal;
+flat in int fHighlighted;
+
+out vec4 fColor;
+
+uniform vec3 lightDir;
+
+void main()
+{
+	vec3 baseColor = fHighlighted != 0 ? vec3(1.0f, 0.25f, 0.2f) : vec3(0.3f, 0.6f, 1.0f);
+	float diffuse = max(dot(normalize(fNormal), normalize(lightDir)), 0.0f);
+	fColor = vec4(baseColor * (0.4f + 0.6f * diffuse), 1.0f);
+}
@@ -0,0 +1,28 @@
+#version 300 es
+precision highp float;
+
+layout(location=0) in vec3 vPosition;
+layout(location=1) in vec3 vNormal;
+// Per instance: bar height in [0, 1]
+layout(location=2) in float vHeight;
+
+out vec3 fNormal;
+flat out int fHighlighted;
+
+uniform float barCount;
+uniform mat4 projection;
+// Indices of the pair the last drained compare or swap touched
+uniform ivec2 highlight;
+
+void main()
+{
+	// cube.obj spans x, z in [-1, 1] and y in [0, 2]; bar i gets the i-th
+	// slot of [-1, 1] and its height
+	float width = 1.0f / barCount;
+	float x = -1.0f + (float(gl_InstanceID) * 2.0f + 1.0f) * width;
+	vec3 position = vec3(x + vPosition.x * width, -1.0f + vPosition.y * vHeight, vPosition.z * 0.5f);
+
+	fNormal = vNormal;
+	fHighlighted = int(gl_InstanceID == highlight.x || gl_InstanceID == highlight.y);
+	gl_Position = projection * vec4(position, 1.0f);
+}
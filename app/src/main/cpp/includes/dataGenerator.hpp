@@ -0,0 +1,51 @@
+//
+// Benchmark input generation: xoshiro256** streams filled on every core
+//
+
+#ifndef dataGenerator_hpp
+#define dataGenerator_hpp
+
+#include <vector>
+#include <cstdint>
+
+#include "matrix.hpp"
+
+// Ids are shared with Kotlin, append only
+enum InputDistribution {
+    INPUT_UNIFORM = 0,       // uniform in [1, 1e6]
+    INPUT_SORTED,
+    INPUT_REVERSED,
+    INPUT_NEARLY_SORTED,     // sorted, then `parameter` random swaps
+    INPUT_FEW_UNIQUE,        // `parameter` distinct values
+    INPUT_ORGAN_PIPE,        // ascending to the middle, then descending
+    INPUT_ZIPF,              // ranks 1..`parameter` with P(r) ~ 1 / r
+    INPUT_DISTRIBUTION_COUNT
+};
+
+// xoshiro256** (Blackman & Vigna). Stream s of a seed is an independent
+// generator, so chunk c of a fill always uses stream c no matter how many
+// threads run, and the output does not depend on the thread count.
+struct Xoshiro256 {
+    uint64_t s[4];
+
+    Xoshiro256(uint64_t seed, uint64_t stream = 0);
+    uint64_t next();
+    // [lo, hi] by multiply-shift instead of a modulo; the bias is below
+    // (hi - lo + 1) / 2^64, far under what any benchmark can observe
+    int64_t nextInRange(int64_t lo, int64_t hi);
+    // Uniform in [0, 1)
+    double nextDouble();
+};
+
+const char* getInputDistributionName(int distribution);
+
+// parameter <= 0 picks the default of the distribution
+std::vector<int> generateInput(int distribution, int arraySize, int parameter = 0,
+                               uint64_t seed = 12345);
+
+// Uniform integers in [lo, hi], rows are spread over the threads. Instantiated
+// for int, long, long long, float and double
+template <typename T>
+void fillUniformMatrix(Matrix<T>& matrix, long lo, long hi, uint64_t seed = 12345);
+
+#endif /* dataGenerator_hpp */
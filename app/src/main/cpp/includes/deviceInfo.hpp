@@ -0,0 +1,38 @@
+//
+// Device queries implemented in myapplication.cpp, shared with the benchmarks
+//
+
+#ifndef deviceInfo_hpp
+#define deviceInfo_hpp
+
+#include <string>
+#include <vector>
+
+// MemAvailable from /proc/meminfo, in kB (0 if it cannot be read)
+long getMemAvailableKb();
+
+// Data cache sizes in bytes of the fastest cores, from the SoC database;
+// 32 KB / 512 KB / 2 MB when the hardware or board is not in it
+struct CacheSizes {
+    long l1;
+    long l2;
+    long l3;
+};
+
+CacheSizes lookupCacheSizes(const std::string& hardware, const std::string& board);
+
+// Ids are shared with Kotlin, append only
+enum CoreCluster {
+    CLUSTER_ALL = 0,
+    CLUSTER_BIG,        // every CPU faster than the slowest ones
+    CLUSTER_LITTLE,     // the CPUs with the lowest cpuinfo_max_freq
+};
+
+// CPUs of the cluster this process may run on. With one frequency (or no
+// cpufreq) every CPU counts as big and the little cluster is empty.
+std::vector<int> getClusterCpus(int cluster);
+
+// Restricts the calling thread to cpus; false when the kernel refuses
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+#endif /* deviceInfo_hpp */
@@ -0,0 +1,119 @@
+//
+// Element types the typed sort kernels are instantiated for. Comparison and
+// radix digit extraction are resolved per type at compile time through
+// ElementTraits<T>, so a kernel has no runtime dispatch in its inner loop.
+//
+
+#ifndef elementTraits_hpp
+#define elementTraits_hpp
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// 64-bit key with a 32-bit payload, ordered by key then payload
+typedef std::pair<uint64_t, uint32_t> KeyPayload;
+
+// Ids are shared with Kotlin, append only
+enum ElementType {
+    ELEMENT_INT8 = 0,
+    ELEMENT_INT16,
+    ELEMENT_INT32,
+    ELEMENT_INT64,
+    ELEMENT_FLOAT,
+    ELEMENT_DOUBLE,
+    ELEMENT_KEY_PAYLOAD,
+    ELEMENT_TYPE_COUNT
+};
+
+const char* getElementTypeName(int elementType);
+
+// less(a, b) is the strict weak order every kernel sorts by.
+// radixByte(v, b) is byte b (0 = least significant) of an unsigned key whose
+// order matches less; KEY_BYTES is the number of bytes the key has.
+template <typename T>
+struct ElementTraits;
+
+// Signed integers: the key is the value with the sign bit flipped
+template <typename T, typename Key>
+struct SignedIntegerTraits {
+    static const int KEY_BYTES = sizeof(T);
+
+    static inline bool less(T a, T b) { return a < b; }
+
+    static inline unsigned radixByte(T v, int b)
+    {
+        Key key = (Key) v ^ ((Key) 1 << (KEY_BYTES * 8 - 1));
+        return (unsigned) (key >> (b * 8)) & 0xFF;
+    }
+};
+
+template <> struct ElementTraits<int8_t> : SignedIntegerTraits<int8_t, uint8_t> {};
+template <> struct ElementTraits<int16_t> : SignedIntegerTraits<int16_t, uint16_t> {};
+template <> struct ElementTraits<int32_t> : SignedIntegerTraits<int32_t, uint32_t> {};
+template <> struct ElementTraits<int64_t> : SignedIntegerTraits<int64_t, uint64_t> {};
+
+// IEEE floats. NaN policy: every NaN sorts after +inf and all NaNs are
+// equivalent, whatever their sign or payload. -0.0 and +0.0 are equal under
+// less; the radix key puts -0.0 first, which is one of the valid orders.
+// Positive values get the sign bit set, negative values are inverted, so
+// the bit pattern orders like the value.
+template <typename T, typename Key>
+struct FloatingPointTraits {
+    static const int KEY_BYTES = sizeof(T);
+
+    static inline bool less(T a, T b) { return a < b || (std::isnan(b) && !std::isnan(a)); }
+
+    static inline unsigned radixByte(T v, int b)
+    {
+        const Key SIGN = (Key) 1 << (KEY_BYTES * 8 - 1);
+        Key key;
+        if (std::isnan(v))
+            key = ~(Key) 0;
+        else
+        {
+            memcpy(&key, &v, sizeof(key));
+            key = (key & SIGN) ? ~key : key | SIGN;
+        }
+        return (unsigned) (key >> (b * 8)) & 0xFF;
+    }
+};
+
+template <> struct ElementTraits<float> : FloatingPointTraits<float, uint32_t> {};
+template <> struct ElementTraits<double> : FloatingPointTraits<double, uint64_t> {};
+
+// Key-payload pairs: a 12 byte key, the payload in the low 4 bytes
+template <>
+struct ElementTraits<KeyPayload> {
+    static const int KEY_BYTES = 12;
+
+    static inline bool less(const KeyPayload& a, const KeyPayload& b)
+    {
+        return a.first < b.first || (a.first == b.first && a.second < b.second);
+    }
+
+    static inline unsigned radixByte(const KeyPayload& v, int b)
+    {
+        if (b < 4)
+            return (v.second >> (b * 8)) & 0xFF;
+        return (unsigned) (v.first >> ((b - 4) * 8)) & 0xFF;
+    }
+};
+
+// Explicit instantiations of a kernel for every element type and both
+// metrics policies, at the end of the file defining the kernel
+#define INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, T) \
+    template void kernel<T, SortMetrics>(Span<T>, SortMetrics&); \
+    template void kernel<T, NoMetrics>(Span<T>, NoMetrics&);
+
+#define INSTANTIATE_ELEMENT_KERNEL(kernel) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, int8_t) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, int16_t) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, int32_t) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, int64_t) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, float) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, double) \
+    INSTANTIATE_ELEMENT_KERNEL_FOR(kernel, KeyPayload)
+
+#endif /* elementTraits_hpp */
@@ -0,0 +1,107 @@
+//
+// Dense row-major matrix in one 64-byte aligned allocation
+//
+
+#ifndef matrix_hpp
+#define matrix_hpp
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+static const int MATRIX_ALIGNMENT = 64;
+
+// Element (i, j) lives at data()[i * stride() + j]. By default every row
+// starts on a cache line: the stride is cols rounded up to a whole line.
+// padding adds that many elements on top, which moves power-of-two strides
+// off the cache set they would otherwise all map to. Padding elements stay
+// zero and no kernel writes them.
+template <typename T>
+class Matrix {
+public:
+    Matrix() : rowCount(0), colCount(0), rowStride(0), elements(nullptr) {}
+
+    Matrix(int rows, int cols, int padding = 0, bool alignRows = true)
+        : rowCount(rows), colCount(cols), rowStride(strideFor(cols, padding, alignRows)), elements(nullptr)
+    {
+        size_t bytes = (size_t) rows * rowStride * sizeof(T);
+        if (bytes > 0)
+        {
+            // posix_memalign, aligned_alloc needs API 28
+            void* memory = nullptr;
+            if (posix_memalign(&memory, MATRIX_ALIGNMENT, bytes) != 0)
+                throw std::bad_alloc();
+            memset(memory, 0, bytes);
+            elements = (T*) memory;
+        }
+    }
+
+    Matrix(const Matrix&) = delete;
+    Matrix& operator=(const Matrix&) = delete;
+
+    Matrix(Matrix&& other) noexcept : Matrix() { swap(other); }
+    Matrix& operator=(Matrix&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~Matrix() { free(elements); }
+
+    static int strideFor(int cols, int padding, bool alignRows)
+    {
+        const int perLine = MATRIX_ALIGNMENT / sizeof(T);
+        int stride = alignRows ? (cols + perLine - 1) / perLine * perLine : cols;
+        return stride + padding;
+    }
+
+    T* operator[](int i) { return elements + (size_t) i * rowStride; }
+    const T* operator[](int i) const { return elements + (size_t) i * rowStride; }
+
+    int rows() const { return rowCount; }
+    int cols() const { return colCount; }
+    int stride() const { return rowStride; }
+    T* data() { return elements; }
+    const T* data() const { return elements; }
+    // Allocated bytes, padding included
+    size_t bytes() const { return (size_t) rowCount * rowStride * sizeof(T); }
+
+    void setZero()
+    {
+        if (elements)
+            memset(elements, 0, bytes());
+    }
+
+    // Compares the logical elements only, padding is ignored
+    bool operator==(const Matrix& other) const
+    {
+        if (rowCount != other.rowCount || colCount != other.colCount)
+            return false;
+        for (int i = 0; i < rowCount; i++)
+        {
+            for (int j = 0; j < colCount; j++)
+            {
+                if ((*this)[i][j] != other[i][j])
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    void swap(Matrix& other) noexcept
+    {
+        std::swap(rowCount, other.rowCount);
+        std::swap(colCount, other.colCount);
+        std::swap(rowStride, other.rowStride);
+        std::swap(elements, other.elements);
+    }
+
+private:
+    int rowCount;
+    int colCount;
+    int rowStride;
+    T* elements;
+};
+
+#endif /* matrix_hpp */
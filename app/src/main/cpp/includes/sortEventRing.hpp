@@ -0,0 +1,168 @@
+//
+// Sort-step events and the lock-free single-producer single-consumer ring
+// that carries them from the sorting thread to the GL thread
+//
+
+#ifndef sortEventRing_hpp
+#define sortEventRing_hpp
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <vector>
+#include <cstdint>
+#include <condition_variable>
+#include <algorithm>
+
+#include "sortingAlg.hpp"
+
+enum SortEventType {
+    SORT_EVENT_COMPARE = 0,
+    SORT_EVENT_SWAP = 1,
+};
+
+// 8 bytes per step: the event type lives in the top bit of the first index
+struct SortEvent {
+    uint32_t first;
+    uint32_t second;
+
+    static SortEvent make(SortEventType type, int i, int j)
+    {
+        return {(uint32_t) i | ((uint32_t) type << 31), (uint32_t) j};
+    }
+
+    SortEventType type() const { return (SortEventType) (first >> 31); }
+    int i() const { return (int) (first & 0x7FFFFFFF); }
+    int j() const { return (int) second; }
+};
+
+// Capacity is a power of two and the indices run freely, so head - tail is
+// the fill level. head and tail sit on their own cache lines, and each side
+// keeps a private copy of the other's index so it only reads the shared one
+// when the copy says the ring is full (producer) or empty (consumer).
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(int capacityLog2)
+        : slots(1u << capacityLog2), mask((1u << capacityLog2) - 1) {}
+
+    // Producer side
+    bool tryPush(const T& value)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - cachedTail > mask)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h - cachedTail > mask)
+                return false;
+        }
+        slots[h & mask] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, moves up to maxCount values into out and returns how many
+    int popBulk(T* out, int maxCount)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (cachedHead == t)
+            cachedHead = head.load(std::memory_order_acquire);
+        int count = (int) std::min<uint32_t>(cachedHead - t, (uint32_t) maxCount);
+        for (int k = 0; k < count; k++)
+            out[k] = slots[(t + k) & mask];
+        tail.store(t + count, std::memory_order_release);
+        return count;
+    }
+
+    // Only while no producer is running
+    void reset()
+    {
+        head.store(0, std::memory_order_relaxed);
+        tail.store(0, std::memory_order_relaxed);
+        cachedHead = cachedTail = 0;
+    }
+
+private:
+    std::vector<T> slots;
+    uint32_t mask;
+    alignas(64) std::atomic<uint32_t> head{0};
+    uint32_t cachedTail = 0;
+    alignas(64) std::atomic<uint32_t> tail{0};
+    uint32_t cachedHead = 0;
+};
+
+typedef SpscRing<SortEvent> SortEventRing;
+
+// Thrown out of a kernel when the visualization is stopped mid-sort
+struct SortCancelled {};
+
+// Lets a producer facing a full ring sleep until the consumer has made room.
+// The generation counter only moves under the lock, so a drain between the
+// failed push and the wait is never missed. Touched once per drain and once
+// per full ring, never per event.
+class SortEventSignal {
+public:
+    uint64_t generation()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return drains;
+    }
+
+    // Consumer, after popping events; also used to wake a cancelled producer
+    void notify()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            drains++;
+        }
+        changed.notify_one();
+    }
+
+    // Producer: returns once notify() ran after seen was read, or on timeout
+    void waitPast(uint64_t seen, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_for(lock, timeout, [&] { return drains != seen; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint64_t drains = 0;
+};
+
+// Metrics policy that streams every compare and swap into the ring. When the
+// consumer falls behind the sort sleeps until the next drain, so the
+// animation sets the pace and a paused renderer costs no CPU; a set cancel
+// flag unwinds the sort instead.
+struct SortEventMetrics {
+    NullCounter assigments;
+    NullCounter comparison;
+    SortEventRing* ring;
+    SortEventSignal* signal;
+    const std::atomic<bool>* cancel;
+
+    SortEventMetrics(SortEventRing* r, SortEventSignal* s, const std::atomic<bool>* c)
+        : ring(r), signal(s), cancel(c) {}
+
+    void onCompare(int i, int j) { push(SortEvent::make(SORT_EVENT_COMPARE, i, j)); }
+    void onSwap(int i, int j) { push(SortEvent::make(SORT_EVENT_SWAP, i, j)); }
+
+    void push(const SortEvent& event)
+    {
+        if (ring->tryPush(event))
+            return;
+        for (;;)
+        {
+            uint64_t seen = signal->generation();
+            if (ring->tryPush(event))
+                return;
+            if (cancel->load(std::memory_order_relaxed))
+                throw SortCancelled();
+            // The timeout only guards against a consumer that never notifies
+            signal->waitPast(seen, std::chrono::milliseconds(100));
+        }
+    }
+};
+
+#endif /* sortEventRing_hpp */
@@ -0,0 +1,17 @@
+//
+// Instanced bar renderer animating bubbleSort / HeapSort steps
+//
+
+#ifndef sortVisualizer_hpp
+#define sortVisualizer_hpp
+
+#include <android/asset_manager.h>
+
+// GL thread, once per new context: shader, cube mesh and instance buffers
+void initSortVisualizer(AAssetManager* assetManager);
+// True while a visualization was started and not stopped
+bool sortVisualizerActive();
+// GL thread: replays the queued sort steps and draws every bar in one call
+void drawSortVisualizer(int screenWidth, int screenHeight);
+
+#endif /* sortVisualizer_hpp */
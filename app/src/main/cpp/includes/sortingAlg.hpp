@@ -0,0 +1,281 @@
+//
+// Sort engines shared by the CPU benchmark
+//
+
+#ifndef sortingAlg_hpp
+#define sortingAlg_hpp
+
+#include <vector>
+#include <cstdint>
+
+// Metrics policies. Every kernel is a template over one of them: SortMetrics
+// counts, NoMetrics has the same members but they compile to nothing, so the
+// timing pass runs the exact same code without the counters.
+// onCompare/onSwap report the indices of a step to the sort visualizer's
+// policy (sortEventRing.hpp); here they are empty.
+struct SortMetrics {
+    long assigments = 0;
+    long comparison = 0;
+    long long duration_ns = 0;          // uninstrumented pass
+    long long counted_duration_ns = 0;  // counting pass
+
+    void onCompare(int, int) {}
+    void onSwap(int, int) {}
+};
+
+struct NullCounter {
+    NullCounter& operator++() { return *this; }
+    NullCounter operator++(int) { return *this; }
+    template <typename T>
+    NullCounter& operator+=(const T&) { return *this; }
+};
+
+struct NoMetrics {
+    NullCounter assigments;
+    NullCounter comparison;
+
+    void onCompare(int, int) {}
+    void onSwap(int, int) {}
+};
+
+// Non-owning view of the elements a kernel sorts. A std::vector converts to
+// it implicitly, and JNI code can wrap a pinned IntArray or a direct
+// ByteBuffer the same way, so every engine sorts caller-owned memory without
+// a copy.
+template <typename T>
+struct Span {
+    T* ptr;
+    int length;
+
+    Span(T* data, int size) : ptr(data), length(size) {}
+    Span(std::vector<T>& v) : ptr(v.data()), length((int) v.size()) {}
+
+    T& operator[](int i) const { return ptr[i]; }
+    int size() const { return length; }
+    T* data() const { return ptr; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + length; }
+};
+
+typedef Span<int> IntSpan;
+
+// Counted primitives shared by the instrumented kernels
+template <typename Metrics>
+inline bool lessThan(int a, int b, Metrics& metrics)
+{
+    metrics.comparison++;
+    return a < b;
+}
+
+template <typename Metrics>
+inline void swapCounted(int& a, int& b, Metrics& metrics)
+{
+    metrics.assigments += 3;
+    int tmp = a;
+    a = b;
+    b = tmp;
+}
+
+// Every engine sorts the array in place and accumulates its counters in metrics
+typedef void (*SortFunction)(IntSpan array, SortMetrics& metrics);
+typedef void (*TimedSortFunction)(IntSpan array, NoMetrics& metrics);
+
+// Explicit instantiations for both policies, at the end of the file defining the kernel
+#define INSTANTIATE_SORT_KERNEL(kernel) \
+    template void kernel<SortMetrics>(IntSpan, SortMetrics&); \
+    template void kernel<NoMetrics>(IntSpan, NoMetrics&);
+
+// Ids are what the Kotlin side passes through JNI, keep them stable
+enum SortEngineId {
+    SORT_BUBBLE = 0,
+    SORT_HEAP = 1,
+    SORT_INTRO = 2,
+    SORT_PDQ = 3,
+    SORT_MERGE_BOTTOM_UP = 4,
+    SORT_TIM = 5,
+    SORT_STD = 6,
+    SORT_STD_STABLE = 7,
+    SORT_HEAP_FLOYD = 8,
+    SORT_HEAP_4ARY = 9,
+    SORT_HEAP_8ARY = 10,
+    SORT_HEAP_BLOCKED = 11,
+    SORT_PARALLEL_SAMPLE = 12,
+    SORT_PARALLEL_MERGE = 13,
+    SORT_QUICK_NETWORK_LEAVES = 14,
+    SORT_MERGE_SIMD = 15,
+    SORT_LSD_RADIX_8 = 16,
+    SORT_LSD_RADIX_11 = 17,
+    SORT_MSD_RADIX_64 = 18,
+    SORT_BUBBLE_BRANCHLESS = 19,
+    SORT_HEAP_BRANCHLESS = 20,
+    SORT_BLOCK_QUICK = 21,
+    SORT_INSERTION = 22,
+    SORT_QUICK_BRANCHY = 23,
+};
+
+struct SortEngine {
+    int id;
+    const char* name;
+    SortFunction sort;          // counting pass
+    TimedSortFunction sortTimed;  // timing pass
+    int scratchKeys;            // peak extra memory in keys per sorted key, rounded up
+};
+
+// Original kernels (sortingAlg.cpp), templates over the element type as
+// well; instantiated for every type in elementTraits.hpp
+template <typename T, typename Metrics>
+void bubbleSort(Span<T> array, Metrics& metrics);
+template <typename T, typename Metrics>
+void HeapSort(Span<T> array, Metrics& metrics);
+// Sifts array[i] down the max-heap array[0, n)
+template <typename T, typename Metrics>
+void maxHeapify(Span<T> array, int n, int i, Metrics& metrics);
+
+// Production-grade comparison sorts (sortEngines.cpp)
+template <typename Metrics>
+void introSort(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void pdqSort(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void mergeSortBottomUp(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void timSort(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void stdSort(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void stdStableSort(IntSpan array, Metrics& metrics);
+
+template <typename Metrics>
+void insertionSort(IntSpan array, Metrics& metrics);
+
+// Building blocks shared between kernels (sortEngines.cpp)
+template <typename Metrics>
+void insertionSortRange(IntSpan array, int begin, int end, Metrics& metrics);
+template <typename Metrics>
+void heapSortRange(IntSpan array, int begin, int end, Metrics& metrics);
+// Stable merge of src[lo, mid) and src[mid, hi) into dst[lo, hi)
+template <typename Metrics>
+void mergeRuns(const int* src, int* dst, int lo, int mid, int hi, Metrics& metrics);
+
+// Cache-conscious heap sort variants (heapSortVariants.cpp)
+template <typename Metrics>
+void floydHeapSort(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void heapSort4ary(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void heapSort8ary(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void blockedHeapSort(IntSpan array, Metrics& metrics);
+
+// Multi-threaded sorts (parallelSort.cpp). threadTimesMs receives the busy
+// time of every worker; fewer threads are used when the array is small.
+int getOnlineCoreCount();
+template <typename Metrics>
+void parallelSampleSort(IntSpan array, int threadCount, Metrics& metrics, std::vector<double>& threadTimesMs);
+template <typename Metrics>
+void parallelMergeSort(IntSpan array, int threadCount, Metrics& metrics, std::vector<double>& threadTimesMs);
+template <typename Metrics>
+void parallelSampleSortAllCores(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void parallelMergeSortAllCores(IntSpan array, Metrics& metrics);
+
+// SIMD sorting-network leaves (simdSort.cpp). The network kernels use
+// SSE4.1 or NEON when this build targets it, scalar lanes otherwise.
+enum SortingNetwork {
+    NETWORK_BITONIC = 0,
+    NETWORK_ODD_EVEN = 1,
+};
+
+enum LeafKernel {
+    LEAF_INSERTION = 0,
+    LEAF_NETWORK_BITONIC = 1,
+    LEAF_NETWORK_ODD_EVEN = 2,
+};
+
+struct LeafSortTiming {
+    double totalMs = 0;
+    double leafMs = 0;
+};
+
+const char* getSimdIsaName();
+template <typename Metrics>
+LeafSortTiming quickSortWithLeaves(IntSpan array, LeafKernel leaf, Metrics& metrics);
+template <typename Metrics>
+LeafSortTiming mergeSortWithLeaves(IntSpan array, LeafKernel leaf, Metrics& metrics);
+template <typename Metrics>
+void quickSortNetworkLeaves(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void mergeSortSimd(IntSpan array, Metrics& metrics);
+
+// Radix sorts (radixSort.cpp)
+template <typename Metrics>
+void lsdRadixSort8(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void lsdRadixSort11(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void msdRadixSort64(std::vector<int64_t>& keys, Metrics& metrics);
+template <typename Metrics>
+void msdRadixSortHybrid(IntSpan array, Metrics& metrics);
+// LSD radix sort on the ElementTraits key of any element type, 8-bit digits
+template <typename T, typename Metrics>
+void lsdRadixSortElements(Span<T> array, Metrics& metrics);
+
+// Branch-free variants (branchlessSort.cpp)
+template <typename Metrics>
+void bubbleSortBranchless(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void heapSortBranchless(IntSpan array, Metrics& metrics);
+template <typename Metrics>
+void blockQuickSort(IntSpan array, Metrics& metrics);
+// BlockQuicksort's loop with a plain branching partition
+template <typename Metrics>
+void quickSortBranchy(IntSpan array, Metrics& metrics);
+
+// Top-k selection (topKSelect.cpp). Every variant writes the k smallest
+// elements of array to out in ascending order and leaves array unchanged.
+template <typename Metrics>
+void topKNthElement(IntSpan array, int k, std::vector<int>& out, Metrics& metrics);
+template <typename Metrics>
+void topKPartialSort(IntSpan array, int k, std::vector<int>& out, Metrics& metrics);
+template <typename Metrics>
+void topKBoundedHeap(IntSpan array, int k, std::vector<int>& out, Metrics& metrics);
+template <typename Metrics>
+void topKParallel(IntSpan array, int k, int threadCount, std::vector<int>& out, Metrics& metrics);
+
+// Registry
+const std::vector<SortEngine>& getSortEngines();
+const SortEngine* findSortEngine(int id);
+// Frees the grow-only scratch buffers the engines keep on the calling thread
+void releaseSortScratch();
+void releaseMergeScratch();
+void releaseBlockedHeapScratch();
+void releaseSimdMergeScratch();
+void releaseRadixScratch();
+
+// Random input shared by every benchmark mode, uniform in [1, 1e6] (INPUT_UNIFORM)
+std::vector<int> generateSortInput(int arraySize);
+
+// Runs the counting pass on a copy of the array, then the uninstrumented
+// timing pass on the array itself; fills in the counters and both durations
+SortMetrics runSortEngine(const SortEngine& engine, IntSpan array);
+
+// Packed result record handed to Kotlin as a LongArray: a fixed header
+// followed by one uninstrumented sort time in ns per iteration. Counts and
+// the counting pass time are from the first iteration, every iteration
+// sorts a fresh copy of the same input.
+enum SortRecordField {
+    RECORD_ENGINE_ID = 0,
+    RECORD_ARRAY_SIZE,
+    RECORD_COMPARISONS,
+    RECORD_ASSIGNMENTS,
+    RECORD_ITERATIONS,
+    RECORD_COUNTED_NS,
+    RECORD_HEADER_SIZE,
+    RECORD_SAMPLES = RECORD_HEADER_SIZE
+};
+
+// Appends the record of `iterations` runs of engine on input to out
+void appendSortRecord(const SortEngine& engine, const std::vector<int>& input, int iterations,
+                      std::vector<int64_t>& out);
+
+#endif /* sortingAlg_hpp */
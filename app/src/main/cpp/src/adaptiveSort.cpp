@@ -0,0 +1,284 @@
+//
+// Adaptive sort front-end. About a thousand sampled pairs estimate how
+// presorted the input is, the cache sizes of the SoC say how much of it stays
+// on chip, and together they pick insertion sort, an LSD radix sort, pdqsort
+// or the parallel sample sort. The pick and the reason for it are reported.
+//
+#include <jni.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdarg>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/sortingAlg.hpp"
+#include "../includes/dataGenerator.hpp"
+#include "../includes/deviceInfo.hpp"
+
+#define LOG_TAG "AdaptiveSort"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const int ADAPTIVE_SAMPLE_SIZE = 1024;
+static const int TINY_ARRAY_SIZE = 32;
+// Sampled fraction of out-of-order pairs below which the input counts as presorted
+static const double PRESORTED_FRACTION = 1.0 / 32;
+// Places an element may be out of position for the input to count as
+// presorted. Insertion sort pays the whole distance, so a few far swaps
+// cost as much as every local one together.
+static const int LOCAL_DISPLACEMENT_LIMIT = 32;
+// Element moves per element insertion sort may spend before pdqsort takes
+// over. Under 1/32 descents that each move under 32 places need about one,
+// so a wrong guess costs at most one extra pass.
+static const int PRESORTED_MOVE_BUDGET = 1;
+static const int RADIX_MIN_SIZE = 1 << 12;
+static const int PARALLEL_MIN_SIZE = 1 << 17;
+// The benchmark skips plain insertion sort above this size
+static const int FIXED_INSERTION_MAX_SIZE = 1 << 15;
+// Histogram bytes of the fused counting pass of lsdRadixSort11: 3 digits x 2048 ints
+static const long RADIX_11_HISTOGRAM_BYTES = 3 * 2048 * sizeof(int);
+
+struct PresortProfile {
+    double descentFraction;     // sampled adjacent pairs out of order
+    double inversionFraction;   // sampled random pairs out of order
+    int maxDisplacement;        // bound on how far sampled descents travel, above LOCAL_DISPLACEMENT_LIMIT when far
+};
+
+struct AdaptiveChoice {
+    int engineId;
+    string reason;
+};
+
+// Gallops from the descent array[i] > array[i + 1] to bound how far back the
+// smaller key and how far forward the larger one belong. The bound exceeds
+// limit only when one of them is more than limit places out.
+template <typename Metrics>
+static int descentDisplacement(IntSpan array, int i, int limit, Metrics &metrics)
+{
+    int n = array.size();
+    int back = 1;
+    while (back <= limit && i - back >= 0 && lessThan(array[i + 1], array[i - back], metrics))
+        back *= 2;
+    int forward = 1;
+    while (forward <= limit && i + 1 + forward < n && lessThan(array[i + 1 + forward], array[i], metrics))
+        forward *= 2;
+    return max(back, forward);
+}
+
+template <typename Metrics>
+static PresortProfile samplePresortedness(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    Xoshiro256 rng(n);
+    int descents = 0, inversions = 0, maxDisplacement = 0;
+    for (int s = 0; s < ADAPTIVE_SAMPLE_SIZE; s++)
+    {
+        int i = rng.nextInRange(0, n - 2);
+        if (lessThan(array[i + 1], array[i], metrics))
+        {
+            descents++;
+            if (maxDisplacement <= LOCAL_DISPLACEMENT_LIMIT)
+                maxDisplacement = max(maxDisplacement, descentDisplacement(array, i, LOCAL_DISPLACEMENT_LIMIT, metrics));
+        }
+
+        int a = rng.nextInRange(0, n - 1);
+        int b = rng.nextInRange(0, n - 1);
+        if (a > b)
+            swap(a, b);
+        inversions += lessThan(array[b], array[a], metrics);
+    }
+    return {(double) descents / ADAPTIVE_SAMPLE_SIZE, (double) inversions / ADAPTIVE_SAMPLE_SIZE, maxDisplacement};
+}
+
+// Insertion sort that stops once it has moved more than budget elements in
+// total, or finds a key the sample missed that is more than maxShift places
+// out: one that would move back further, or a larger one carried forward
+// by more than maxShift inserts in a row.
+// The array is a permutation of the input either way; true when sorted.
+template <typename Metrics>
+static bool boundedInsertionSort(IntSpan array, long budget, int maxShift, Metrics &metrics)
+{
+    long moves = 0;
+    int carried = 0;
+    for (int i = 1; i < array.size(); i++)
+    {
+        int key = array[i];
+        int j = i - 1;
+        int stop = max(-1, i - 1 - maxShift);
+        while (j > stop && lessThan(key, array[j], metrics))
+        {
+            array[j + 1] = array[j];
+            metrics.assigments++;
+            j--;
+        }
+        array[j + 1] = key;
+        metrics.assigments += 2;
+        moves += i - 1 - j;
+        carried = j < i - 1 ? carried + 1 : 0;
+        if (moves > budget || carried > maxShift || (j == stop && j >= 0 && lessThan(key, array[j], metrics)))
+            return false;
+    }
+    return true;
+}
+
+static string formatReason(const char *format, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return buffer;
+}
+
+template <typename Metrics>
+static AdaptiveChoice adaptiveSort(IntSpan array, const CacheSizes &caches, Metrics &metrics)
+{
+    int n = array.size();
+    if (n <= TINY_ARRAY_SIZE)
+    {
+        insertionSort(array, metrics);
+        return {SORT_INSERTION, formatReason("%d elements, below the %d element cutoff", n, TINY_ARRAY_SIZE)};
+    }
+
+    PresortProfile profile = samplePresortedness(array, metrics);
+    string presort = formatReason("%.1f%% sampled descents, %.1f%% sampled inversions",
+                                  profile.descentFraction * 100, profile.inversionFraction * 100);
+
+    // Descending input is reversed, then sampled again like any other
+    if (profile.descentFraction > 1 - PRESORTED_FRACTION && profile.inversionFraction > 1 - PRESORTED_FRACTION)
+    {
+        reverse(array.begin(), array.end());
+        metrics.assigments += n;
+        profile = samplePresortedness(array, metrics);
+        presort += formatReason(", reversed to %.1f%% descents", profile.descentFraction * 100);
+    }
+
+    if (profile.descentFraction < PRESORTED_FRACTION && profile.inversionFraction < PRESORTED_FRACTION)
+    {
+        // pdqsort keeps the long sorted stretches cheap without paying for the far keys
+        if (profile.maxDisplacement > LOCAL_DISPLACEMENT_LIMIT)
+        {
+            pdqSort(array, metrics);
+            return {SORT_PDQ, presort + formatReason(": presorted but a sampled descent is more than %d places out, pdqsort",
+                                                     LOCAL_DISPLACEMENT_LIMIT)};
+        }
+        if (boundedInsertionSort(array, (long) PRESORTED_MOVE_BUDGET * n, LOCAL_DISPLACEMENT_LIMIT, metrics))
+            return {SORT_INSERTION, presort + formatReason(": presorted, insertion sort finished within %d move per element",
+                                                           PRESORTED_MOVE_BUDGET)};
+        pdqSort(array, metrics);
+        return {SORT_PDQ, presort + formatReason(": looked presorted but insertion sort ran past %d move per element or met a key more than %d places out, pdqsort finished",
+                                                 PRESORTED_MOVE_BUDGET, LOCAL_DISPLACEMENT_LIMIT)};
+    }
+
+    long workingSet = (long) n * sizeof(int);
+    long lastLevel = caches.l3 > 0 ? caches.l3 : caches.l2;
+    int cores = getOnlineCoreCount();
+    if (n >= PARALLEL_MIN_SIZE && workingSet > lastLevel && cores > 1)
+    {
+        parallelSampleSortAllCores(array, metrics);
+        return {SORT_PARALLEL_SAMPLE, presort + formatReason(": %ld KB of keys exceed the %ld KB last-level cache, sample sort on %d cores",
+                                                             workingSet / 1024, lastLevel / 1024, cores)};
+    }
+
+    if (n >= RADIX_MIN_SIZE)
+    {
+        if (RADIX_11_HISTOGRAM_BYTES <= caches.l1)
+        {
+            lsdRadixSort11(array, metrics);
+            return {SORT_LSD_RADIX_11, presort + formatReason(": unsorted and at least %d elements, 11-bit digit histograms (%ld KB) fit the %ld KB L1",
+                                                              RADIX_MIN_SIZE, RADIX_11_HISTOGRAM_BYTES / 1024, caches.l1 / 1024)};
+        }
+        lsdRadixSort8(array, metrics);
+        return {SORT_LSD_RADIX_8, presort + formatReason(": unsorted and at least %d elements, 11-bit histograms would not fit the %ld KB L1, 8-bit digits",
+                                                         RADIX_MIN_SIZE, caches.l1 / 1024)};
+    }
+
+    pdqSort(array, metrics);
+    return {SORT_PDQ, presort + formatReason(": unsorted and below %d elements, pdqsort", RADIX_MIN_SIZE)};
+}
+
+static long long elapsedNs(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count();
+}
+
+static string jstringToStdString(JNIEnv *env, jstring value)
+{
+    const char *chars = env->GetStringUTFChars(value, NULL);
+    string result(chars);
+    env->ReleaseStringUTFChars(value, chars);
+    return result;
+}
+
+// Sorts data in place with the strategy the selector picks for it and this
+// device's caches. Returns "<engine name>: <reason>"
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_myapplication_testCpuWithSorting_adaptiveSortIntArray(JNIEnv *env, jobject, jstring hardware, jstring board, jintArray data)
+{
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+
+    jint *elements = env->GetIntArrayElements(data, NULL);
+    if (elements == NULL)
+    {
+        LOGE("Could not access the array");
+        return NULL;
+    }
+    NoMetrics metrics;
+    AdaptiveChoice choice = adaptiveSort(IntSpan(elements, env->GetArrayLength(data)), caches, metrics);
+    env->ReleaseIntArrayElements(data, elements, 0);
+
+    string report = string(findSortEngine(choice.engineId)->name) + ": " + choice.reason;
+    return env->NewStringUTF(report.c_str());
+}
+
+// The selector against every strategy it can pick, on every InputDistribution.
+// Returns rows of [distribution, picked engine id, adaptive ns, insertion ns,
+// LSD radix 8 ns, LSD radix 11 ns, pdqsort ns, parallel sample sort ns];
+// adaptive ns includes the sampling, insertion ns is -1 above 32768 elements.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runAdaptiveSortBenchmark(JNIEnv *env, jobject, jstring hardware, jstring board, jint arraySize)
+{
+    const int fixedEngines[] = {SORT_INSERTION, SORT_LSD_RADIX_8, SORT_LSD_RADIX_11, SORT_PDQ, SORT_PARALLEL_SAMPLE};
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+
+    vector<jlong> report;
+    for (int distribution = 0; distribution < INPUT_DISTRIBUTION_COUNT; distribution++)
+    {
+        vector<int> input = generateInput(distribution, arraySize);
+        vector<int> expected = input;
+        sort(expected.begin(), expected.end());
+
+        vector<int> data = input;
+        NoMetrics metrics;
+        auto start = chrono::high_resolution_clock::now();
+        AdaptiveChoice choice = adaptiveSort(data, caches, metrics);
+        long long adaptiveNs = elapsedNs(start);
+        if (data != expected)
+            LOGE("Adaptive sort left %s input unsorted", getInputDistributionName(distribution));
+
+        report.push_back(distribution);
+        report.push_back(choice.engineId);
+        report.push_back(adaptiveNs);
+
+        for (int id : fixedEngines)
+        {
+            if (id == SORT_INSERTION && (int) input.size() > FIXED_INSERTION_MAX_SIZE)
+            {
+                report.push_back(-1);
+                continue;
+            }
+            data = input;
+            start = chrono::high_resolution_clock::now();
+            findSortEngine(id)->sortTimed(data, metrics);
+            report.push_back(elapsedNs(start));
+        }
+    }
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
@@ -0,0 +1,302 @@
+//
+// Branch-free variants of the bubble, heap and quick sort kernels. The data
+// dependent decisions become min/max, index arithmetic and offset buffers,
+// so running them next to the branchy originals on sorted and random input
+// shows what a mispredicted branch costs on the device.
+//
+#include <jni.h>
+#include <vector>
+#include <algorithm>
+
+#include "../includes/sortingAlg.hpp"
+#include "../includes/dataGenerator.hpp"
+
+using namespace std;
+
+static const int BLOCK_PARTITION_SIZE = 64;
+static const int BLOCK_QUICK_INSERTION_THRESHOLD = 24;
+
+// ----------------------------------------------------------------------------
+// Bubble sort: the larger element is carried along the pass in a register,
+// every step is one min and one max, which compile to conditional moves
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+void bubbleSortBranchless(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    for (int i = 0; i < n - 1; i++)
+    {
+        int carry = array[0];
+        int swapped = 0;
+        for (int j = 0; j < n - i - 1; j++)
+        {
+            int next = array[j + 1];
+            swapped |= next < carry;
+            array[j] = min(carry, next);
+            carry = max(carry, next);
+        }
+        array[n - i - 1] = carry;
+        metrics.comparison += n - i - 1;
+        metrics.assigments += n - i;
+        if (!swapped)
+            break;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Heap sort: Floyd's sift where the larger child is picked by adding the
+// comparison result to the index, so the way down has no data-dependent branch
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+static void branchlessSiftDown(IntSpan array, int n, int i, Metrics &metrics)
+{
+    int value = array[i];
+    int hole = i;
+
+    int child;
+    while ((child = 2 * hole + 1) < n - 1)
+    {
+        child += array[child] < array[child + 1];
+        array[hole] = array[child];
+        metrics.comparison++;
+        metrics.assigments++;
+        hole = child;
+    }
+    if (child == n - 1)
+    {
+        array[hole] = array[child];
+        metrics.assigments++;
+        hole = child;
+    }
+
+    while (hole > i)
+    {
+        int parent = (hole - 1) / 2;
+        if (!lessThan(array[parent], value, metrics))
+            break;
+        array[hole] = array[parent];
+        metrics.assigments++;
+        hole = parent;
+    }
+
+    array[hole] = value;
+    metrics.assigments += 2;
+}
+
+template <typename Metrics>
+void heapSortBranchless(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    for (int i = n / 2 - 1; i >= 0; i--)
+        branchlessSiftDown(array, n, i, metrics);
+    for (int i = n - 1; i > 0; i--)
+    {
+        swapCounted(array[0], array[i], metrics);
+        branchlessSiftDown(array, i, 0, metrics);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// BlockQuicksort (Edelkamp & Weiss): scan a block from each end and write
+// the offsets of misplaced elements into small buffers, always advancing the
+// count by the comparison result, then swap the buffered pairs. The only
+// branches left depend on block counts, not on the data.
+//
+// The branchy quicksort below runs the same loop with the same pivot and
+// equal-key handling, only its partition branches on every comparison, so
+// the pair measures nothing but the branches.
+// ----------------------------------------------------------------------------
+
+// Lomuto-style pass over [first, last] with one data-dependent branch per
+// element. Returns the index of the first element of the right part.
+template <typename GoesLeft, typename Metrics>
+static int branchyPartition(IntSpan array, int first, int last, GoesLeft goesLeft, Metrics &metrics)
+{
+    int split = first;
+    for (int j = first; j <= last; j++)
+    {
+        metrics.comparison++;
+        if (goesLeft(array[j]))
+        {
+            swapCounted(array[split], array[j], metrics);
+            split++;
+        }
+    }
+    return split;
+}
+
+// Partitions [first, last] so elements with goesLeft(x) come first.
+// Returns the index of the first element of the right part.
+template <typename GoesLeft, typename Metrics>
+static int blockPartition(IntSpan array, int first, int last, GoesLeft goesLeft, Metrics &metrics)
+{
+    unsigned char offsetsLeft[BLOCK_PARTITION_SIZE];
+    unsigned char offsetsRight[BLOCK_PARTITION_SIZE];
+    int countLeft = 0, countRight = 0;
+    int startLeft = 0, startRight = 0;
+
+    // Everything before first goes left, everything after last goes right
+    while (last - first + 1 > 2 * BLOCK_PARTITION_SIZE)
+    {
+        if (countLeft == 0)
+        {
+            startLeft = 0;
+            for (int i = 0; i < BLOCK_PARTITION_SIZE; i++)
+            {
+                offsetsLeft[countLeft] = (unsigned char) i;
+                countLeft += !goesLeft(array[first + i]);
+            }
+            metrics.comparison += BLOCK_PARTITION_SIZE;
+        }
+        if (countRight == 0)
+        {
+            startRight = 0;
+            for (int i = 0; i < BLOCK_PARTITION_SIZE; i++)
+            {
+                offsetsRight[countRight] = (unsigned char) i;
+                countRight += goesLeft(array[last - i]);
+            }
+            metrics.comparison += BLOCK_PARTITION_SIZE;
+        }
+
+        int swaps = min(countLeft, countRight);
+        for (int k = 0; k < swaps; k++)
+            swapCounted(array[first + offsetsLeft[startLeft + k]],
+                        array[last - offsetsRight[startRight + k]], metrics);
+
+        countLeft -= swaps;
+        countRight -= swaps;
+        startLeft += swaps;
+        startRight += swaps;
+        if (countLeft == 0)
+            first += BLOCK_PARTITION_SIZE;
+        if (countRight == 0)
+            last -= BLOCK_PARTITION_SIZE;
+    }
+
+    // Fewer than three blocks left, finish with a plain pass
+    return branchyPartition(array, first, last, goesLeft, metrics);
+}
+
+template <bool Blocked, typename GoesLeft, typename Metrics>
+static inline int partitionRange(IntSpan array, int first, int last, GoesLeft goesLeft, Metrics &metrics)
+{
+    return Blocked ? blockPartition(array, first, last, goesLeft, metrics)
+                   : branchyPartition(array, first, last, goesLeft, metrics);
+}
+
+template <bool Blocked, typename Metrics>
+static void quickSortLoop(IntSpan array, int begin, int end, int depthLimit, bool leftmost, Metrics &metrics)
+{
+    while (end - begin > BLOCK_QUICK_INSERTION_THRESHOLD)
+    {
+        if (depthLimit == 0)
+        {
+            heapSortRange(array, begin, end, metrics);
+            return;
+        }
+        depthLimit--;
+
+        // Median of 3 moved to array[begin]
+        int mid = begin + (end - begin) / 2;
+        if (lessThan(array[mid], array[begin], metrics)) swapCounted(array[begin], array[mid], metrics);
+        if (lessThan(array[end - 1], array[mid], metrics)) swapCounted(array[mid], array[end - 1], metrics);
+        if (lessThan(array[mid], array[begin], metrics)) swapCounted(array[begin], array[mid], metrics);
+        swapCounted(array[begin], array[mid], metrics);
+        int pivot = array[begin];
+
+        // Same pivot as the element left of the range: all keys equal to it
+        // go left and are done, which keeps few-unique input linear
+        if (!leftmost && !lessThan(array[begin - 1], pivot, metrics))
+        {
+            begin = partitionRange<Blocked>(array, begin + 1, end - 1,
+                                            [pivot](int x) { return x <= pivot; }, metrics);
+            continue;
+        }
+
+        int split = partitionRange<Blocked>(array, begin + 1, end - 1,
+                                            [pivot](int x) { return x < pivot; }, metrics);
+        int pivotPos = split - 1;
+        swapCounted(array[begin], array[pivotPos], metrics);
+
+        if (pivotPos - begin < end - (pivotPos + 1))
+        {
+            quickSortLoop<Blocked>(array, begin, pivotPos, depthLimit, leftmost, metrics);
+            begin = pivotPos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            quickSortLoop<Blocked>(array, pivotPos + 1, end, depthLimit, false, metrics);
+            end = pivotPos;
+        }
+    }
+    insertionSortRange(array, begin, end, metrics);
+}
+
+template <bool Blocked, typename Metrics>
+static void quickSortDriver(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    int depthLimit = 0;
+    for (int m = n; m > 1; m >>= 1)
+        depthLimit += 2;
+    quickSortLoop<Blocked>(array, 0, n, depthLimit, true, metrics);
+}
+
+template <typename Metrics>
+void blockQuickSort(IntSpan array, Metrics &metrics)
+{
+    quickSortDriver<true>(array, metrics);
+}
+
+template <typename Metrics>
+void quickSortBranchy(IntSpan array, Metrics &metrics)
+{
+    quickSortDriver<false>(array, metrics);
+}
+
+INSTANTIATE_SORT_KERNEL(bubbleSortBranchless)
+INSTANTIATE_SORT_KERNEL(heapSortBranchless)
+INSTANTIATE_SORT_KERNEL(blockQuickSort)
+INSTANTIATE_SORT_KERNEL(quickSortBranchy)
+
+// Every branchy kernel and its branch-free variant on sorted and on random
+// input. Each pair shares its algorithm (Floyd's sift for the heaps, the
+// same pivot and recursion for the quicksorts), so only the branches
+// differ. Returns [engine id, sorted ns, sorted comparisons, random ns,
+// random comparisons] per engine; ns per comparison on each input gives
+// the misprediction penalty.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runBranchMispredictionBenchmark(JNIEnv *env, jobject, jint arraySize)
+{
+    const int engines[] = {
+            SORT_BUBBLE, SORT_BUBBLE_BRANCHLESS,
+            SORT_HEAP_FLOYD, SORT_HEAP_BRANCHLESS,
+            SORT_QUICK_BRANCHY, SORT_BLOCK_QUICK
+    };
+    vector<int> sorted = generateInput(INPUT_SORTED, arraySize);
+    vector<int> random = generateInput(INPUT_UNIFORM, arraySize);
+
+    vector<jlong> report;
+    for (int id : engines)
+    {
+        const SortEngine &engine = *findSortEngine(id);
+        vector<int> sortedData = sorted;
+        SortMetrics sortedMetrics = runSortEngine(engine, sortedData);
+        vector<int> randomData = random;
+        SortMetrics randomMetrics = runSortEngine(engine, randomData);
+
+        report.push_back(id);
+        report.push_back(sortedMetrics.duration_ns);
+        report.push_back(sortedMetrics.comparison);
+        report.push_back(randomMetrics.duration_ns);
+        report.push_back(randomMetrics.comparison);
+    }
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
@@ -0,0 +1,276 @@
+//
+// Input distributions for the sort and matrix benchmarks. Every fill is cut
+// into fixed chunks with one generator stream each, and the chunks are
+// spread over the online cores.
+//
+#include <jni.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+#include "../includes/dataGenerator.hpp"
+#include "../includes/sortingAlg.hpp"
+
+using namespace std;
+
+static const int MAX_INPUT_VALUE = 1000000;
+static const int FILL_CHUNK = 1 << 16;
+static const int DEFAULT_FEW_UNIQUE = 16;
+static const int DEFAULT_ZIPF_RANKS = 1000;
+
+static const char *distributionNames[INPUT_DISTRIBUTION_COUNT] = {
+        "Uniform",
+        "Sorted",
+        "Reversed",
+        "Nearly Sorted",
+        "Few Unique",
+        "Organ Pipe",
+        "Zipf"
+};
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitMix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed, uint64_t stream)
+{
+    uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ull);
+    for (uint64_t &word : s)
+        word = splitMix64(x);
+}
+
+uint64_t Xoshiro256::next()
+{
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+// High 64 bits of a * b from four 32x32 partial products; unsigned __int128
+// does not exist on the 32-bit ABIs
+static inline uint64_t mulHigh64(uint64_t a, uint64_t b)
+{
+    uint64_t aLo = (uint32_t) a, aHi = a >> 32;
+    uint64_t bLo = (uint32_t) b, bHi = b >> 32;
+    uint64_t loLo = aLo * bLo;
+    uint64_t hiLo = aHi * bLo;
+    uint64_t loHi = aLo * bHi;
+    uint64_t hiHi = aHi * bHi;
+    uint64_t middle = (loLo >> 32) + (uint32_t) hiLo + (uint32_t) loHi;
+    return hiHi + (hiLo >> 32) + (loHi >> 32) + (middle >> 32);
+}
+
+int64_t Xoshiro256::nextInRange(int64_t lo, int64_t hi)
+{
+    uint64_t range = (uint64_t) (hi - lo) + 1;
+    return lo + (int64_t) mulHigh64(next(), range);
+}
+
+double Xoshiro256::nextDouble()
+{
+    return (next() >> 11) * 0x1.0p-53;
+}
+
+const char *getInputDistributionName(int distribution)
+{
+    if (distribution < 0 || distribution >= INPUT_DISTRIBUTION_COUNT)
+        return nullptr;
+    return distributionNames[distribution];
+}
+
+// Calls fill(lo, hi, rng) for every chunk of n, chunk c with stream c of seed
+template <typename Fill>
+static void parallelFill(long long n, uint64_t seed, Fill fill, long long chunkSize = FILL_CHUNK)
+{
+    long long chunks = (n + chunkSize - 1) / chunkSize;
+    int threadCount = (int) min<long long>(getOnlineCoreCount(), chunks);
+
+    auto work = [&](int t) {
+        for (long long c = t; c < chunks; c += threadCount)
+        {
+            Xoshiro256 rng(seed, c);
+            fill(c * chunkSize, min(n, (c + 1) * chunkSize), rng);
+        }
+    };
+
+    if (threadCount <= 1)
+    {
+        work(0);
+        return;
+    }
+    vector<thread> workers;
+    for (int t = 1; t < threadCount; t++)
+        workers.emplace_back(work, t);
+    work(0);
+    for (thread &worker : workers)
+        worker.join();
+}
+
+// Value of position i in an ascending ramp over [1, MAX_INPUT_VALUE]
+static inline int rampValue(long long i, long long n)
+{
+    return 1 + (int) (i * (MAX_INPUT_VALUE - 1) / max(1LL, n - 1));
+}
+
+vector<int> generateInput(int distribution, int arraySize, int parameter, uint64_t seed)
+{
+    int n = max(0, arraySize);
+    vector<int> data(n);
+    int *out = data.data();
+
+    switch (distribution)
+    {
+        case INPUT_SORTED:
+        case INPUT_NEARLY_SORTED:
+            parallelFill(n, seed, [&](long long lo, long long hi, Xoshiro256 &) {
+                for (long long i = lo; i < hi; i++)
+                    out[i] = rampValue(i, n);
+            });
+            if (distribution == INPUT_NEARLY_SORTED && n > 1)
+            {
+                int swaps = parameter > 0 ? parameter : max(1, n / 100);
+                Xoshiro256 rng(seed, ~0ull);
+                for (int k = 0; k < swaps; k++)
+                    swap(out[rng.nextInRange(0, n - 1)], out[rng.nextInRange(0, n - 1)]);
+            }
+            break;
+
+        case INPUT_REVERSED:
+            parallelFill(n, seed, [&](long long lo, long long hi, Xoshiro256 &) {
+                for (long long i = lo; i < hi; i++)
+                    out[i] = rampValue(n - 1 - i, n);
+            });
+            break;
+
+        case INPUT_FEW_UNIQUE:
+        {
+            int unique = parameter > 0 ? parameter : DEFAULT_FEW_UNIQUE;
+            parallelFill(n, seed, [&](long long lo, long long hi, Xoshiro256 &rng) {
+                for (long long i = lo; i < hi; i++)
+                    out[i] = rampValue(rng.nextInRange(0, unique - 1), unique);
+            });
+            break;
+        }
+
+        case INPUT_ORGAN_PIPE:
+        {
+            long long half = (n + 1) / 2;
+            parallelFill(n, seed, [&](long long lo, long long hi, Xoshiro256 &) {
+                for (long long i = lo; i < hi; i++)
+                    out[i] = rampValue(i < half ? i : n - 1 - i, half);
+            });
+            break;
+        }
+
+        case INPUT_ZIPF:
+        {
+            // Inverse-CDF sampling over the rank table
+            int ranks = parameter > 0 ? parameter : DEFAULT_ZIPF_RANKS;
+            vector<double> cdf(ranks);
+            double total = 0;
+            for (int r = 0; r < ranks; r++)
+            {
+                total += 1.0 / (r + 1);
+                cdf[r] = total;
+            }
+            for (double &c : cdf)
+                c /= total;
+
+            parallelFill(n, seed, [&](long long lo, long long hi, Xoshiro256 &rng) {
+                for (long long i = lo; i < hi; i++)
+                {
+                    int rank = upper_bound(cdf.begin(), cdf.end(), rng.nextDouble()) - cdf.begin();
+                    out[i] = rampValue(min(rank, ranks - 1), ranks);
+                }
+            });
+            break;
+        }
+
+        case INPUT_UNIFORM:
+        default:
+            parallelFill(n, seed, [&](long long lo, long long hi, Xoshiro256 &rng) {
+                for (long long i = lo; i < hi; i++)
+                    out[i] = (int) rng.nextInRange(1, MAX_INPUT_VALUE);
+            });
+            break;
+    }
+    return data;
+}
+
+template <typename T>
+void fillUniformMatrix(Matrix<T> &matrix, long lo, long hi, uint64_t seed)
+{
+    // Chunks are whole rows, about FILL_CHUNK values each
+    int cols = matrix.cols();
+    long long rowsPerChunk = max(1, FILL_CHUNK / max(1, cols));
+    parallelFill(matrix.rows(), seed, [&](long long first, long long last, Xoshiro256 &rng) {
+        for (long long i = first; i < last; i++)
+        {
+            T *row = matrix[i];
+            for (int j = 0; j < cols; j++)
+                row[j] = (T) rng.nextInRange(lo, hi);
+        }
+    }, rowsPerChunk);
+}
+
+template void fillUniformMatrix<int>(Matrix<int> &, long, long, uint64_t);
+template void fillUniformMatrix<long>(Matrix<long> &, long, long, uint64_t);
+template void fillUniformMatrix<long long>(Matrix<long long> &, long, long, uint64_t);
+template void fillUniformMatrix<float>(Matrix<float> &, long, long, uint64_t);
+template void fillUniformMatrix<double>(Matrix<double> &, long, long, uint64_t);
+
+// Input distribution names indexed by id
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_getInputDistributionNames(JNIEnv *env, jobject)
+{
+    jclass stringClass = env->FindClass("java/lang/String");
+    jobjectArray names = env->NewObjectArray(INPUT_DISTRIBUTION_COUNT, stringClass, NULL);
+    for (int d = 0; d < INPUT_DISTRIBUTION_COUNT; d++)
+    {
+        jstring name = env->NewStringUTF(distributionNames[d]);
+        env->SetObjectArrayElement(names, d, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+// Setup cost of the old generator against this one on the same size.
+// Returns [mt19937 ns, xoshiro ns]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runInputGenerationBenchmark(JNIEnv *env, jobject, jint arraySize)
+{
+    auto start = chrono::high_resolution_clock::now();
+    mt19937 gen(12345);
+    uniform_int_distribution<int> dis(1, MAX_INPUT_VALUE);
+    vector<int> reference(max(0, (int) arraySize));
+    for (int &value : reference)
+        value = dis(gen);
+    auto middle = chrono::high_resolution_clock::now();
+    vector<int> generated = generateInput(INPUT_UNIFORM, arraySize);
+    auto end = chrono::high_resolution_clock::now();
+
+    jlong times[2] = {
+            chrono::duration_cast<chrono::nanoseconds>(middle - start).count(),
+            chrono::duration_cast<chrono::nanoseconds>(end - middle).count()
+    };
+    jlongArray result = env->NewLongArray(2);
+    env->SetLongArrayRegion(result, 0, 2, times);
+    return result;
+}
@@ -0,0 +1,486 @@
+//
+// Out-of-core external sort: a key file larger than RAM is cut into runs
+// sized so a run plus the engine's scratch fits the memory budget, every run
+// is sorted in memory and written back, then the runs are merged through a loser tree, in one pass unless
+// the budget cannot hold a buffer for every run.
+// I/O time (read, write, fsync) and CPU time (generation, sorting, merging)
+// are measured separately.
+//
+#include <jni.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <android/log.h>
+
+#include "../includes/sortingAlg.hpp"
+#include "../includes/dataGenerator.hpp"
+#include "../includes/deviceInfo.hpp"
+
+#define LOG_TAG "ExternalSort"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+// The budget is a quarter of MemAvailable, clamped to this range
+static const long long MIN_MEMORY_BUDGET = 4LL << 20;
+static const long long MAX_MEMORY_BUDGET = 512LL << 20;
+static const long long MIN_MERGE_BUFFER = 64LL << 10;
+
+struct ExternalSortReport {
+    long long keys = 0;
+    int runs = 0;
+    int mergePasses = 0;
+    long long budgetBytes = 0;
+    double generateCpuMs = 0;
+    double generateIoMs = 0;
+    double runIoMs = 0;
+    double runCpuMs = 0;
+    double mergeIoMs = 0;
+    double mergeCpuMs = 0;
+    bool sorted = true;
+};
+
+typedef chrono::high_resolution_clock::time_point TimePoint;
+
+static inline TimePoint now()
+{
+    return chrono::high_resolution_clock::now();
+}
+
+static inline double elapsedMs(TimePoint start)
+{
+    return chrono::duration<double, milli>(now() - start).count();
+}
+
+static bool writeFully(int fd, const void *data, size_t bytes, off64_t offset)
+{
+    const char *p = (const char *) data;
+    while (bytes > 0)
+    {
+        ssize_t written = pwrite64(fd, p, bytes, offset);
+        if (written <= 0)
+            return false;
+        p += written;
+        offset += written;
+        bytes -= written;
+    }
+    return true;
+}
+
+static bool readFully(int fd, void *data, size_t bytes, off64_t offset)
+{
+    char *p = (char *) data;
+    while (bytes > 0)
+    {
+        ssize_t got = pread64(fd, p, bytes, offset);
+        if (got <= 0)
+            return false;
+        p += got;
+        offset += got;
+        bytes -= got;
+    }
+    return true;
+}
+
+// fsync, then drop the file from the page cache so the next pass reads storage
+static void flushToStorage(int fd)
+{
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+static long long memoryBudgetBytes()
+{
+    long long available = (long long) getMemAvailableKb() * 1024;
+    return min(MAX_MEMORY_BUDGET, max(MIN_MEMORY_BUDGET, available / 4));
+}
+
+// ----------------------------------------------------------------------------
+// Loser tree over k run heads: every inner node keeps the loser of its match,
+// slot 0 the overall winner, so replacing the winner replays one leaf-to-root
+// path with log2(k) comparisons against the stored losers.
+// ----------------------------------------------------------------------------
+
+// Exhausted runs compare greater than any int key
+static const int64_t EXHAUSTED_KEY = INT64_MAX;
+
+struct LoserTree {
+    int leaves;
+    vector<int> tree;
+    vector<int64_t> keys;
+
+    explicit LoserTree(int k)
+    {
+        leaves = 1;
+        while (leaves < k)
+            leaves *= 2;
+        tree.assign(leaves, 0);
+        keys.assign(leaves, EXHAUSTED_KEY);
+    }
+
+    void build()
+    {
+        tree[0] = play(1);
+    }
+
+    int winner() const
+    {
+        return tree[0];
+    }
+
+    // Call after keys[winner()] changed
+    void replay()
+    {
+        int winner = tree[0];
+        for (int node = (winner + leaves) / 2; node > 0; node /= 2)
+        {
+            if (keys[tree[node]] < keys[winner])
+                swap(tree[node], winner);
+        }
+        tree[0] = winner;
+    }
+
+private:
+    int play(int node)
+    {
+        if (node >= leaves)
+            return node - leaves;
+        int left = play(2 * node);
+        int right = play(2 * node + 1);
+        bool leftWins = keys[left] <= keys[right];
+        tree[node] = leftWins ? right : left;
+        return leftWins ? left : right;
+    }
+};
+
+// One run during the merge: either a refillable pread buffer or a window of the mapped file
+struct RunReader {
+    off64_t next;       // file offset of the next key to load
+    off64_t end;
+    const int *keys;
+    int count;
+    int position;
+    vector<int> buffer;
+};
+
+// ----------------------------------------------------------------------------
+// Phases
+// ----------------------------------------------------------------------------
+
+static bool generateKeyFile(int fd, long long keys, long long budgetKeys, ExternalSortReport &report)
+{
+    vector<int> chunk;
+    for (long long done = 0, part = 0; done < keys; done += chunk.size(), part++)
+    {
+        int count = (int) min(budgetKeys, keys - done);
+        TimePoint start = now();
+        chunk = generateInput(INPUT_UNIFORM, count, 0, 12345 + part);
+        report.generateCpuMs += elapsedMs(start);
+
+        start = now();
+        if (!writeFully(fd, chunk.data(), (size_t) count * sizeof(int), done * sizeof(int)))
+            return false;
+        report.generateIoMs += elapsedMs(start);
+    }
+    TimePoint start = now();
+    flushToStorage(fd);
+    report.generateIoMs += elapsedMs(start);
+    return true;
+}
+
+static bool formRuns(int input, int runsFd, long long keys, long long runKeys, const SortEngine &engine,
+                     ExternalSortReport &report)
+{
+    vector<int> chunk;
+    for (long long done = 0; done < keys; done += chunk.size())
+    {
+        chunk.resize((size_t) min(runKeys, keys - done));
+        size_t bytes = chunk.size() * sizeof(int);
+
+        TimePoint start = now();
+        if (!readFully(input, chunk.data(), bytes, done * sizeof(int)))
+            return false;
+        report.runIoMs += elapsedMs(start);
+
+        start = now();
+        NoMetrics metrics;
+        engine.sortTimed(chunk, metrics);
+        report.runCpuMs += elapsedMs(start);
+
+        start = now();
+        if (!writeFully(runsFd, chunk.data(), bytes, done * sizeof(int)))
+            return false;
+        report.runIoMs += elapsedMs(start);
+        report.runs++;
+    }
+    TimePoint start = now();
+    flushToStorage(runsFd);
+    report.runIoMs += elapsedMs(start);
+    return true;
+}
+
+// Loads the next window of a pread run, returns false when the run is done
+static bool refillRun(int runsFd, RunReader &run, ExternalSortReport &report)
+{
+    if (run.next >= run.end)
+        return false;
+    size_t count = (size_t) min<off64_t>(run.buffer.size(), (run.end - run.next) / sizeof(int));
+    TimePoint start = now();
+    bool ok = readFully(runsFd, run.buffer.data(), count * sizeof(int), run.next);
+    report.mergeIoMs += elapsedMs(start);
+    if (!ok)
+        return false;
+    run.keys = run.buffer.data();
+    run.count = (int) count;
+    run.position = 0;
+    run.next += count * sizeof(int);
+    return true;
+}
+
+// One sorted run of a runs file, byte offsets
+struct RunSpan {
+    off64_t begin;
+    off64_t end;
+};
+
+// Merges the runs of one group into outputFd at the offset of the first run,
+// so a group's output replaces its runs in place in the other file. Keys come
+// from mapped when it is set, otherwise from pread buffers of bufferKeys.
+static bool mergeRunGroup(int inputFd, const int *mapped, const RunSpan *spans, int k, int outputFd,
+                          long long bufferKeys, ExternalSortReport &report)
+{
+    vector<RunReader> runs(k);
+    LoserTree tree(k);
+    for (int r = 0; r < k; r++)
+    {
+        RunReader &run = runs[r];
+        run.next = spans[r].begin;
+        run.end = spans[r].end;
+        if (mapped != nullptr)
+        {
+            run.keys = mapped + run.next / sizeof(int);
+            run.count = (int) ((run.end - run.next) / sizeof(int));
+            run.position = 0;
+            run.next = run.end;
+        }
+        else
+        {
+            run.buffer.resize((size_t) bufferKeys);
+            if (!refillRun(inputFd, run, report))
+                return false;
+        }
+        tree.keys[r] = run.keys[0];
+    }
+
+    TimePoint start = now();
+    tree.build();
+    vector<int> output;
+    output.reserve((size_t) bufferKeys);
+    off64_t written = spans[0].begin;
+    int64_t previous = INT64_MIN;
+
+    while (tree.keys[tree.winner()] != EXHAUSTED_KEY)
+    {
+        int r = tree.winner();
+        RunReader &run = runs[r];
+        int key = (int) tree.keys[r];
+        if (key < previous)
+            report.sorted = false;
+        previous = key;
+        output.push_back(key);
+
+        if (++run.position < run.count)
+            tree.keys[r] = run.keys[run.position];
+        else
+        {
+            report.mergeCpuMs += elapsedMs(start);
+            bool more = mapped == nullptr && refillRun(inputFd, run, report);
+            start = now();
+            tree.keys[r] = more ? run.keys[0] : EXHAUSTED_KEY;
+        }
+        tree.replay();
+
+        if ((long long) output.size() == bufferKeys)
+        {
+            report.mergeCpuMs += elapsedMs(start);
+            TimePoint io = now();
+            if (!writeFully(outputFd, output.data(), output.size() * sizeof(int), written))
+                return false;
+            report.mergeIoMs += elapsedMs(io);
+            written += output.size() * sizeof(int);
+            output.clear();
+            start = now();
+        }
+    }
+    report.mergeCpuMs += elapsedMs(start);
+
+    TimePoint io = now();
+    bool ok = writeFully(outputFd, output.data(), output.size() * sizeof(int), written);
+    report.mergeIoMs += elapsedMs(io);
+    written += output.size() * sizeof(int);
+    return ok && written == spans[k - 1].end;
+}
+
+// Input buffers for k runs plus the output buffer share the budget
+static long long mergeBufferKeys(long long budgetBytes, int k)
+{
+    return max(MIN_MERGE_BUFFER, budgetBytes / (k + 1)) / (long long) sizeof(int);
+}
+
+// With useMmap the page faults of the runs land in the merge CPU time, only
+// the output writes count as I/O. The pread merge gives every run at least
+// MIN_MERGE_BUFFER, so when that many buffers would overshoot the budget,
+// groups of at most budget / MIN_MERGE_BUFFER - 1 runs are first merged back
+// and forth between runsFd and scratchFd until one pass is left.
+static bool mergeSortedRuns(int runsFd, int scratchFd, int outputFd, long long keys, long long runKeys,
+                            bool useMmap, long long budgetBytes, ExternalSortReport &report)
+{
+    off64_t fileBytes = keys * sizeof(int);
+    vector<RunSpan> spans(report.runs);
+    for (int r = 0; r < report.runs; r++)
+    {
+        spans[r].begin = (off64_t) r * runKeys * sizeof(int);
+        spans[r].end = min<off64_t>(fileBytes, spans[r].begin + runKeys * sizeof(int));
+    }
+
+    const int *mapped = nullptr;
+    if (useMmap)
+    {
+        // A 32-bit size_t would silently truncate the mapping
+        if ((unsigned long long) fileBytes > SIZE_MAX)
+            LOGE("%lld bytes do not fit the address space, merging with pread", (long long) fileBytes);
+        else
+        {
+            void *address = mmap(nullptr, (size_t) fileBytes, PROT_READ, MAP_PRIVATE, runsFd, 0);
+            if (address == MAP_FAILED)
+                LOGE("mmap of %lld bytes failed, merging with pread", (long long) fileBytes);
+            else
+            {
+                madvise(address, (size_t) fileBytes, MADV_SEQUENTIAL);
+                mapped = (const int *) address;
+            }
+        }
+    }
+
+    int inputFd = runsFd;
+    if (mapped == nullptr)
+    {
+        int maxFanIn = (int) max(2LL, budgetBytes / MIN_MERGE_BUFFER - 1);
+        while ((int) spans.size() > maxFanIn)
+        {
+            vector<RunSpan> merged;
+            long long bufferKeys = mergeBufferKeys(budgetBytes, maxFanIn);
+            for (size_t first = 0; first < spans.size(); first += maxFanIn)
+            {
+                int k = (int) min<size_t>(maxFanIn, spans.size() - first);
+                if (!mergeRunGroup(inputFd, nullptr, &spans[first], k, scratchFd, bufferKeys, report))
+                    return false;
+                merged.push_back({spans[first].begin, spans[first + k - 1].end});
+            }
+            TimePoint io = now();
+            flushToStorage(scratchFd);
+            report.mergeIoMs += elapsedMs(io);
+            spans.swap(merged);
+            swap(inputFd, scratchFd);
+            report.mergePasses++;
+        }
+    }
+
+    bool ok = mergeRunGroup(inputFd, mapped, spans.data(), (int) spans.size(), outputFd,
+                            mergeBufferKeys(budgetBytes, mapped != nullptr ? 0 : (int) spans.size()), report);
+    TimePoint io = now();
+    flushToStorage(outputFd);
+    report.mergeIoMs += elapsedMs(io);
+    report.mergePasses++;
+
+    if (mapped != nullptr)
+        munmap((void *) mapped, (size_t) fileBytes);
+    return ok;
+}
+
+static bool runExternalSort(const string &directory, long long keys, bool useMmap, const SortEngine &engine,
+                            ExternalSortReport &report)
+{
+    string inputPath = directory + "/extsort_input.bin";
+    string runsPath = directory + "/extsort_runs.bin";
+    string outputPath = directory + "/extsort_output.bin";
+    string scratchPath = directory + "/extsort_merge.bin";
+
+    report.keys = keys;
+    report.budgetBytes = memoryBudgetBytes();
+    long long budgetKeys = report.budgetBytes / sizeof(int);
+    // Out-of-place engines need scratch next to the run
+    long long runKeys = max(1LL, budgetKeys / (1 + engine.scratchKeys));
+
+    int input = open(inputPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    int runsFd = open(runsPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    int output = open(outputPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    int scratch = open(scratchPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+
+    bool ok = input >= 0 && runsFd >= 0 && output >= 0 && scratch >= 0;
+    if (!ok)
+        LOGE("Cannot create the sort files in %s", directory.c_str());
+    ok = ok && generateKeyFile(input, keys, budgetKeys, report);
+    ok = ok && formRuns(input, runsFd, keys, runKeys, engine, report);
+    // The engines keep their scratch for the next call, the merge needs the memory back
+    releaseSortScratch();
+    ok = ok && mergeSortedRuns(runsFd, scratch, output, keys, runKeys, useMmap, report.budgetBytes, report);
+
+    for (int fd : {input, runsFd, output, scratch})
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+    unlink(inputPath.c_str());
+    unlink(runsPath.c_str());
+    unlink(outputPath.c_str());
+    unlink(scratchPath.c_str());
+    return ok;
+}
+
+// Sorts totalMegabytes of int keys through files in directory (the app's filesDir).
+// Returns [keys, runs, budget bytes, generate cpu ms, generate io ms, run io ms,
+// run cpu ms, merge io ms, merge cpu ms, sorted (1/0)]
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runExternalSort(JNIEnv *env, jobject, jstring jDirectory,
+                                                                  jint totalMegabytes, jboolean useMmap, jint engineId)
+{
+    const SortEngine *engine = findSortEngine(engineId);
+    if (engine == nullptr || totalMegabytes <= 0)
+    {
+        LOGE("Bad engine %d or size %d MB", engineId, totalMegabytes);
+        return NULL;
+    }
+
+    const char *chars = env->GetStringUTFChars(jDirectory, NULL);
+    string directory = chars;
+    env->ReleaseStringUTFChars(jDirectory, chars);
+
+    ExternalSortReport report;
+    long long keys = (long long) totalMegabytes * (1 << 20) / sizeof(int);
+    if (!runExternalSort(directory, keys, useMmap, *engine, report))
+    {
+        LOGE("External sort of %d MB failed", totalMegabytes);
+        return NULL;
+    }
+    LOGI("External sort: %lld keys, %d runs, %d merge passes, budget %lld MB, %s scratch %d keys per key",
+         report.keys, report.runs, report.mergePasses, report.budgetBytes >> 20, engine->name, engine->scratchKeys);
+
+    jdouble values[10] = {
+            (double) report.keys, (double) report.runs, (double) report.budgetBytes,
+            report.generateCpuMs, report.generateIoMs,
+            report.runIoMs, report.runCpuMs,
+            report.mergeIoMs, report.mergeCpuMs,
+            report.sorted ? 1.0 : 0.0
+    };
+    jdoubleArray result = env->NewDoubleArray(10);
+    env->SetDoubleArrayRegion(result, 0, 10, values);
+    return result;
+}
@@ -0,0 +1,358 @@
+//
+// Bitonic sort on the GPU with OpenGL ES 3.0 render-to-texture. ES 3.0 has
+// no compute shaders, so every compare-exchange stage is a fragment pass:
+// the keys live in an RGBA32I texture, four per texel, and each pass reads
+// one texture and writes the other through a framebuffer. The context is
+// created here on a pbuffer (or surfaceless) display, so the benchmark runs
+// off the UI's GLSurfaceView and headless under Mesa llvmpipe; for the same
+// reason the shaders are embedded instead of read from the assets.
+//
+#include <jni.h>
+#include <vector>
+#include <chrono>
+#include <climits>
+#include <algorithm>
+#include <android/log.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include "../includes/sortingAlg.hpp"
+
+#define LOG_TAG "GpuSort"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const int KEYS_PER_TEXEL = 4;
+
+static const char* FULLSCREEN_VERTEX_SHADER = R"(#version 300 es
+void main()
+{
+    // One triangle covering the viewport, no vertex buffer needed
+    vec2 corner = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+// One bitonic stage (k, j): key i meets key i ^ j and keeps the smaller one
+// when it is the lower index of an ascending block (i & k == 0) or the higher
+// index of a descending one. All four partners of a texel share a texel, the
+// texel itself when j < 4.
+static const char* BITONIC_FRAGMENT_SHADER = R"(#version 300 es
+precision highp float;
+precision highp int;
+precision highp isampler2D;
+
+uniform isampler2D keys;
+uniform int width;
+uniform int k;
+uniform int j;
+
+out ivec4 result;
+
+void main()
+{
+    int texel = int(gl_FragCoord.y) * width + int(gl_FragCoord.x);
+    ivec4 own = texelFetch(keys, ivec2(gl_FragCoord.xy), 0);
+    int partnerTexel = (texel * 4 ^ j) >> 2;
+    ivec4 other = texelFetch(keys, ivec2(partnerTexel % width, partnerTexel / width), 0);
+
+    for (int lane = 0; lane < 4; lane++)
+    {
+        int i = texel * 4 + lane;
+        int p = i ^ j;
+        int a = own[lane];
+        int b = other[p & 3];
+        bool keepMin = (p > i) == ((i & k) == 0);
+        result[lane] = keepMin ? min(a, b) : max(a, b);
+    }
+}
+)";
+
+struct GpuSortTimes {
+    long long uploadNs = 0;
+    long long sortNs = 0;
+    long long readbackNs = 0;
+    int paddedSize = 0;
+    int passes = 0;
+};
+
+static long long elapsedNs(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// ----------------------------------------------------------------------------
+// Offscreen context
+// ----------------------------------------------------------------------------
+
+struct OffscreenContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+
+    // The default display first (Android, or Mesa with a window system),
+    // then Mesa's surfaceless platform for machines without one
+    bool create()
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+        {
+            display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                    (PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay != NULL)
+                display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (display != EGL_NO_DISPLAY && !eglInitialize(display, NULL, NULL))
+                display = EGL_NO_DISPLAY;
+#endif
+            if (display == EGL_NO_DISPLAY)
+            {
+                LOGE("No EGL display");
+                return false;
+            }
+        }
+
+        // Rendering goes to framebuffer objects, the pbuffer only makes the
+        // context current where surfaceless contexts are not supported
+        EGLint pbufferConfig[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR, EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_NONE};
+        EGLint anyConfig[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT_KHR, EGL_NONE};
+        EGLConfig config;
+        EGLint count = 0;
+        bool pbuffer = eglChooseConfig(display, pbufferConfig, &config, 1, &count) && count > 0;
+        if (!pbuffer && !(eglChooseConfig(display, anyConfig, &config, 1, &count) && count > 0))
+        {
+            LOGE("No OpenGL ES 3 EGL config");
+            return false;
+        }
+
+        eglBindAPI(EGL_OPENGL_ES_API);
+        EGLint contextAttributes[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT)
+        {
+            LOGE("eglCreateContext failed (0x%x)", eglGetError());
+            return false;
+        }
+        if (pbuffer)
+        {
+            EGLint surfaceAttributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+            surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        }
+        if (!eglMakeCurrent(display, surface, surface, context))
+        {
+            LOGE("eglMakeCurrent failed (0x%x)", eglGetError());
+            return false;
+        }
+        return true;
+    }
+
+    ~OffscreenContext()
+    {
+        if (display == EGL_NO_DISPLAY)
+            return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        eglTerminate(display);
+    }
+};
+
+static GLuint compileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok)
+    {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        LOGE("Shader compilation error:\n%s", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static GLuint linkBitonicProgram()
+{
+    GLuint vertex = compileShader(GL_VERTEX_SHADER, FULLSCREEN_VERTEX_SHADER);
+    GLuint fragment = compileShader(GL_FRAGMENT_SHADER, BITONIC_FRAGMENT_SHADER);
+    if (vertex == 0 || fragment == 0)
+    {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex);
+    glAttachShader(program, fragment);
+    glLinkProgram(program);
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok)
+    {
+        char log[512];
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        LOGE("Shader linking error:\n%s", log);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// ----------------------------------------------------------------------------
+// Sort
+// ----------------------------------------------------------------------------
+
+// Sorts data through the current context. The keys are padded with INT_MAX
+// to a power of two of at least 4; false when GL cannot hold them.
+static bool bitonicSortGpu(vector<int>& data, GpuSortTimes& times)
+{
+    int n = data.size();
+    int padded = KEYS_PER_TEXEL;
+    while (padded < n)
+        padded <<= 1;
+    times.paddedSize = padded;
+
+    // Power-of-two texture, as square as the texel count allows
+    int texels = padded / KEYS_PER_TEXEL;
+    int logTexels = 0;
+    while ((1 << logTexels) < texels)
+        logTexels++;
+    int width = 1 << ((logTexels + 1) / 2);
+    int height = texels / width;
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (width > maxSize || height > maxSize)
+    {
+        LOGE("%d keys need a %dx%d texture, the limit is %d", n, width, height, maxSize);
+        return false;
+    }
+
+    GLuint program = linkBitonicProgram();
+    if (program == 0)
+        return false;
+
+    vector<int> keys(padded, INT_MAX);
+    copy(data.begin(), data.end(), keys.begin());
+
+    GLuint textures[2];
+    GLuint framebuffers[2];
+    glGenTextures(2, textures);
+    glGenFramebuffers(2, framebuffers);
+    bool complete = true;
+    for (int t = 0; t < 2; t++)
+    {
+        glBindTexture(GL_TEXTURE_2D, textures[t]);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32I, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[t]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[t], 0);
+        complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "keys"), 0);
+    glUniform1i(glGetUniformLocation(program, "width"), width);
+    GLint kLocation = glGetUniformLocation(program, "k");
+    GLint jLocation = glGetUniformLocation(program, "j");
+    glViewport(0, 0, width, height);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glActiveTexture(GL_TEXTURE0);
+
+    // glFinish closes each phase so its work is not billed to the next one
+    auto start = chrono::high_resolution_clock::now();
+    glBindTexture(GL_TEXTURE_2D, textures[0]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA_INTEGER, GL_INT, keys.data());
+    glFinish();
+    times.uploadNs = elapsedNs(start);
+
+    start = chrono::high_resolution_clock::now();
+    int source = 0;
+    times.passes = 0;
+    for (int k = 2; k <= padded; k <<= 1)
+    {
+        for (int j = k >> 1; j > 0; j >>= 1)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[1 - source]);
+            glBindTexture(GL_TEXTURE_2D, textures[source]);
+            glUniform1i(kLocation, k);
+            glUniform1i(jLocation, j);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            source = 1 - source;
+            times.passes++;
+        }
+    }
+    glFinish();
+    times.sortNs = elapsedNs(start);
+
+    // RGBA_INTEGER / INT is the read format ES 3.0 guarantees for RGBA32I
+    start = chrono::high_resolution_clock::now();
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[source]);
+    glReadPixels(0, 0, width, height, GL_RGBA_INTEGER, GL_INT, keys.data());
+    times.readbackNs = elapsedNs(start);
+
+    GLenum error = glGetError();
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteVertexArrays(1, &vao);
+    glDeleteFramebuffers(2, framebuffers);
+    glDeleteTextures(2, textures);
+    glDeleteProgram(program);
+    if (!complete || error != GL_NO_ERROR)
+    {
+        LOGE("GPU sort failed, framebuffer complete %d, glError 0x%x", complete, error);
+        return false;
+    }
+
+    // The padding sorts to the end
+    copy(keys.begin(), keys.begin() + n, data.begin());
+    return true;
+}
+
+// Bitonic sort of the runAdvanceSort input on the GPU against the CPU
+// HeapSort. Returns [array size, padded size, passes, upload ns, sort ns,
+// readback ns, HeapSort ns, 1 if the GPU result matches], NULL when no
+// OpenGL ES 3 context can be created or the keys do not fit a texture.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runGpuBitonicSort(JNIEnv *env, jobject, jint arraySize)
+{
+    vector<int> input = generateSortInput(max(1, (int) arraySize));
+
+    vector<int> cpu = input;
+    NoMetrics metrics;
+    auto start = chrono::high_resolution_clock::now();
+    HeapSort<int>(cpu, metrics);
+    long long heapSortNs = elapsedNs(start);
+
+    OffscreenContext context;
+    if (!context.create())
+        return NULL;
+    vector<int> gpu = input;
+    GpuSortTimes times;
+    if (!bitonicSortGpu(gpu, times))
+        return NULL;
+
+    bool matches = gpu == cpu;
+    if (!matches)
+        LOGE("GPU bitonic sort disagrees with HeapSort");
+
+    jlong report[] = {(jlong) input.size(), times.paddedSize, times.passes, times.uploadNs, times.sortNs,
+                      times.readbackNs, heapSortNs, matches};
+    jlongArray result = env->NewLongArray(8);
+    env->SetLongArrayRegion(result, 0, 8, report);
+    return result;
+}
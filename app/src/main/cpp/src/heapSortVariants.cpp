@@ -0,0 +1,308 @@
+//
+// Heap sort variants that stay fast once the heap no longer fits in cache.
+// All of them are iterative and move a hole instead of swapping.
+//
+#include <vector>
+#include <new>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../includes/sortingAlg.hpp"
+
+using namespace std;
+
+// ----------------------------------------------------------------------------
+// Floyd bottom-up heap sort: walk the hole down to a leaf with one comparison
+// per level, then climb back up to where the displaced element belongs.
+// The element taken from the end is almost always small, so the climb is short.
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+static void floydSiftDown(IntSpan array, int n, int i, Metrics &metrics)
+{
+    int value = array[i];
+    int hole = i;
+
+    int child;
+    while ((child = 2 * hole + 1) < n)
+    {
+        if (child + 1 < n && lessThan(array[child], array[child + 1], metrics))
+            child++;
+        array[hole] = array[child];
+        metrics.assigments++;
+        hole = child;
+    }
+
+    while (hole > i)
+    {
+        int parent = (hole - 1) / 2;
+        if (!lessThan(array[parent], value, metrics))
+            break;
+        array[hole] = array[parent];
+        metrics.assigments++;
+        hole = parent;
+    }
+
+    array[hole] = value;
+    metrics.assigments += 2;
+}
+
+template <typename Metrics>
+void floydHeapSort(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    for (int i = n / 2 - 1; i >= 0; i--)
+        floydSiftDown(array, n, i, metrics);
+    for (int i = n - 1; i > 0; i--)
+    {
+        swapCounted(array[0], array[i], metrics);
+        floydSiftDown(array, i, 0, metrics);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// d-ary heaps: log_d(n) levels instead of log2(n), and the d children of a
+// node sit next to each other, so every level costs one cache line at most
+// ----------------------------------------------------------------------------
+
+template <int D, typename Metrics>
+static void dArySiftDown(IntSpan array, int n, int i, Metrics &metrics)
+{
+    int value = array[i];
+    while (true)
+    {
+        int first = D * i + 1;
+        if (first >= n)
+            break;
+        int last = min(first + D, n);
+
+        int largest = first;
+        for (int c = first + 1; c < last; c++)
+        {
+            if (lessThan(array[largest], array[c], metrics))
+                largest = c;
+        }
+        if (!lessThan(value, array[largest], metrics))
+            break;
+
+        array[i] = array[largest];
+        metrics.assigments++;
+        i = largest;
+    }
+    array[i] = value;
+    metrics.assigments += 2;
+}
+
+template <int D, typename Metrics>
+static void dAryHeapSort(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    if (n < 2)
+        return;
+    for (int i = (n - 2) / D; i >= 0; i--)
+        dArySiftDown<D>(array, n, i, metrics);
+    for (int i = n - 1; i > 0; i--)
+    {
+        swapCounted(array[0], array[i], metrics);
+        dArySiftDown<D>(array, i, 0, metrics);
+    }
+}
+
+template <typename Metrics>
+void heapSort4ary(IntSpan array, Metrics &metrics)
+{
+    dAryHeapSort<4>(array, metrics);
+}
+
+template <typename Metrics>
+void heapSort8ary(IntSpan array, Metrics &metrics)
+{
+    dAryHeapSort<8>(array, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// B-heap (Kamp): the binary heap is cut into subtrees of 4 levels and every
+// subtree is stored in its own 64-byte block, so one cache miss pays for
+// 4 levels of the sift instead of one. The root block takes the leftover
+// levels, which keeps every block below it at least half full.
+//
+// Block layout: 15 nodes in slots 0..14 (slot 15 is padding), the 8 bottom
+// slots each have 2 child blocks. Blocks are numbered level by level, so the
+// 16 children of block b >= 1 are rootChildren + 1 + (b - 1) * 16 + k.
+// ----------------------------------------------------------------------------
+
+static const int BHEAP_BLOCK_LEVELS = 4;
+static const int BHEAP_BLOCK_STRIDE = 16;
+static const int BHEAP_BLOCK_NODES = 15;
+static const int BHEAP_FIRST_LEAF = 7;
+static const int BHEAP_ALIGNMENT = 64;
+
+// Grow-only scratch for the heap. Blocks only map onto single cache lines
+// when the storage starts on a line, which vector<int> does not promise.
+struct AlignedIntBuffer {
+    int *data = nullptr;
+    size_t capacity = 0;
+
+    ~AlignedIntBuffer() { free(data); }
+
+    int *reserve(size_t count)
+    {
+        if (count > capacity)
+        {
+            // posix_memalign, aligned_alloc needs API 28
+            void *memory = nullptr;
+            if (posix_memalign(&memory, BHEAP_ALIGNMENT, count * sizeof(int)) != 0)
+                throw bad_alloc();
+            free(data);
+            data = (int *) memory;
+            capacity = count;
+        }
+        return data;
+    }
+
+    void release()
+    {
+        free(data);
+        data = nullptr;
+        capacity = 0;
+    }
+};
+
+struct BHeapLayout {
+    int rootLevels;     // levels stored in block 0
+    int rootChildren;   // child blocks hanging off block 0
+    int rootFirstLeaf;  // first bottom slot of block 0
+};
+
+// Where a node lives: logical is the usual implicit-heap index, used for the
+// size checks; block and slot give the physical position.
+struct BHeapNode {
+    int logical;
+    int block;
+    int slot;
+};
+
+static inline int bheapPhysical(const BHeapNode &node)
+{
+    return node.block * BHEAP_BLOCK_STRIDE + node.slot;
+}
+
+static BHeapLayout bheapMakeLayout(int n)
+{
+    int levels = 0;
+    while ((1 << levels) - 1 < n)
+        levels++;
+
+    BHeapLayout layout;
+    layout.rootLevels = levels == 0 ? 1 : (levels - 1) % BHEAP_BLOCK_LEVELS + 1;
+    layout.rootChildren = 1 << layout.rootLevels;
+    layout.rootFirstLeaf = (1 << (layout.rootLevels - 1)) - 1;
+    return layout;
+}
+
+// Maps a logical heap index to its block and slot
+static BHeapNode bheapLocate(const BHeapLayout &layout, int logical)
+{
+    int depth = 31 - __builtin_clz((unsigned) logical + 1);
+
+    if (depth < layout.rootLevels)
+        return {logical, 0, logical};
+
+    int position = logical + 1 - (1 << depth);
+    int below = depth - layout.rootLevels;
+    int blockLevel = below / BHEAP_BLOCK_LEVELS;
+    int inDepth = below % BHEAP_BLOCK_LEVELS;
+
+    // First block of this block level: 1 + rootChildren * (16^blockLevel - 1) / 15
+    long long firstBlock = 1 + (long long) layout.rootChildren *
+                               (((long long) 1 << (4 * blockLevel)) - 1) / BHEAP_BLOCK_NODES;
+    int block = (int) (firstBlock + (position >> inDepth));
+    int slot = (1 << inDepth) - 1 + (position & ((1 << inDepth) - 1));
+    return {logical, block, slot};
+}
+
+// Left (side 0) or right (side 1) child of a node
+static inline BHeapNode bheapChild(const BHeapLayout &layout, const BHeapNode &node, int side)
+{
+    int firstLeaf = node.block == 0 ? layout.rootFirstLeaf : BHEAP_FIRST_LEAF;
+    if (node.slot < firstLeaf)
+        return {2 * node.logical + 1 + side, node.block, 2 * node.slot + 1 + side};
+
+    int k = 2 * (node.slot - firstLeaf) + side;
+    int block = node.block == 0 ? 1 + k
+                                : layout.rootChildren + 1 + (node.block - 1) * BHEAP_BLOCK_STRIDE + k;
+    return {2 * node.logical + 1 + side, block, 0};
+}
+
+template <typename Metrics>
+static void bheapSiftDown(int *heap, const BHeapLayout &layout, int n, BHeapNode node, Metrics &metrics)
+{
+    int value = heap[bheapPhysical(node)];
+    while (2 * node.logical + 1 < n)
+    {
+        BHeapNode child = bheapChild(layout, node, 0);
+        if (child.logical + 1 < n)
+        {
+            BHeapNode right = bheapChild(layout, node, 1);
+            if (lessThan(heap[bheapPhysical(child)], heap[bheapPhysical(right)], metrics))
+                child = right;
+        }
+        if (!lessThan(value, heap[bheapPhysical(child)], metrics))
+            break;
+
+        heap[bheapPhysical(node)] = heap[bheapPhysical(child)];
+        metrics.assigments++;
+        node = child;
+    }
+    heap[bheapPhysical(node)] = value;
+    metrics.assigments += 2;
+}
+
+static thread_local AlignedIntBuffer bheapScratch;
+
+void releaseBlockedHeapScratch()
+{
+    bheapScratch.release();
+}
+
+template <typename Metrics>
+void blockedHeapSort(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    if (n < 2)
+        return;
+
+    BHeapLayout layout = bheapMakeLayout(n);
+    // The highest block is either the one holding the last node, or the one
+    // holding the right end of the level above it
+    int deepest = 31 - __builtin_clz((unsigned) n);
+    int lastBlock = max(bheapLocate(layout, n - 1).block,
+                        bheapLocate(layout, (1 << deepest) - 2).block);
+
+    int *heap = bheapScratch.reserve((size_t) (lastBlock + 1) * BHEAP_BLOCK_STRIDE);
+
+    for (int i = 0; i < n; i++)
+        heap[bheapPhysical(bheapLocate(layout, i))] = array[i];
+    metrics.assigments += n;
+
+    for (int i = n / 2 - 1; i >= 0; i--)
+        bheapSiftDown(heap, layout, n, bheapLocate(layout, i), metrics);
+
+    // Sort-down writes the maxima straight into the output array
+    BHeapNode root = {0, 0, 0};
+    for (int i = n - 1; i > 0; i--)
+    {
+        BHeapNode tail = bheapLocate(layout, i);
+        array[i] = heap[0];
+        heap[0] = heap[bheapPhysical(tail)];
+        metrics.assigments += 2;
+        bheapSiftDown(heap, layout, i, root, metrics);
+    }
+    array[0] = heap[0];
+    metrics.assigments++;
+}
+
+INSTANTIATE_SORT_KERNEL(floydHeapSort)
+INSTANTIATE_SORT_KERNEL(heapSort4ary)
+INSTANTIATE_SORT_KERNEL(heapSort8ary)
+INSTANTIATE_SORT_KERNEL(blockedHeapSort)
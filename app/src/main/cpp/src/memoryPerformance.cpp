@@ -6,93 +6,1000 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <thread>
+#include <atomic>
 #include <sstream>
 #include <android/log.h>
 #include <random>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE2__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+#include "../includes/dataGenerator.hpp"
+#include "../includes/matrix.hpp"
+#include "../includes/deviceInfo.hpp"
 
 #define LOG_TAG "MatrixBenchmark"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
 using namespace std;
 using namespace std::chrono;
 
-void multiplyMatrices_IJK( long **A, long **B, long** C, int size)
+// Inner product order: B is walked down a column, one cache line per step
+// once a row of B no longer fits
+template <typename T>
+void multiplyMatrices_IJK(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C)
 {
-    for (int i=0; i<size; i++) {
+    int size = C.rows();
+    for (int i = 0; i < size; i++) {
         for (int j = 0; j < size; j++) {
-            C[i][j] = 0;
-            for (int k = 0; k < size; k++) {
-                C[i][j] += A[i][k] * B[k][j];
-            }
+            T sum = 0;
+            for (int k = 0; k < size; k++)
+                sum += A[i][k] * B[k][j];
+            C[i][j] = sum;
         }
     }
 }
 
-void multiplyMatrices_IKJ( long **A, long **B, long** C, int size){
+// Row-streaming order, the same product: row i of C accumulates A[i][k]
+// times row k of B, so the inner loop reads B and writes C sequentially
+template <typename T>
+void multiplyMatrices_IKJ(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C)
+{
+    int size = C.rows();
     for (int i = 0; i < size; i++) {
+        T *c = C[i];
+        for (int j = 0; j < size; j++)
+            c[j] = 0;
         for (int k = 0; k < size; k++) {
+            T a = A[i][k];
+            const T *b = B[k];
             for (int j = 0; j < size; j++)
-                C[i][j] += A[i][j] * B[j][k];
+                c[j] += a * b[j];
         }
     }
 }
-extern "C" JNIEXPORT jdoubleArray JNICALL
-Java_com_example_myapplication_MemoryPerformanceActivity_runMatrixBenchmark(JNIEnv *env, jobject, jlong cacheSize) {
-    long **A = (long **) calloc(cacheSize, sizeof(long *));
-    for (int i = 0; i < cacheSize; i++)
-        A[i] = (long *) calloc(cacheSize, sizeof(long));
 
-    long **B = (long **) calloc(cacheSize, sizeof(long *));
-    for (int i = 0; i < cacheSize; i++)
-        B[i] = (long *) calloc(cacheSize, sizeof(long));
+// ----------------------------------------------------------------------------
+// Cache-blocked GEMM. C is computed one nc-wide column panel at a time; in
+// it a kc x nc block of B is reused by every row of an mc x kc block of A,
+// and the innermost loop streams one nc-long row of that B block into one
+// row of C.
+// ----------------------------------------------------------------------------
+
+struct TileShape {
+    int mc;     // rows of A per block
+    int kc;     // depth of the A and B blocks
+    int nc;     // columns of B and C per block
+};
+
+static int roundDownToLine(int elements, int elementBytes)
+{
+    int perLine = max(1, MATRIX_ALIGNMENT / elementBytes);
+    return max(perLine, elements / perLine * perLine);
+}
+
+// Half of each level for the block it should hold, the rest is left for the
+// other operands and whatever else lives there:
+//   L1: one row of the B block and one row of C    2 * nc      elements
+//   L2: the kc x nc block of B, about square       kc * nc     elements
+//   L3: the mc x kc block of A (L2 without an L3)  mc * kc     elements
+// Every dimension is clamped to the matrix before the next one is derived
+// from it. Sizing nc from L1 alone gave blocks wider than any benchmarked
+// matrix and a kc of 16, so every C row was streamed N / 16 times.
+static TileShape tileShapeForCaches(const CacheSizes &caches, int elementBytes, int size)
+{
+    long lastLevel = caches.l3 > 0 ? caches.l3 : caches.l2;
+    size = max(1, size);
+    int l1Columns = roundDownToLine(caches.l1 / 2 / (2 * elementBytes), elementBytes);
+    int squareEdge = roundDownToLine((int) sqrt((double) caches.l2 / 2 / elementBytes), elementBytes);
+    TileShape shape;
+    shape.nc = min(size, min(l1Columns, squareEdge));
+    shape.kc = min(size, roundDownToLine(caches.l2 / 2 / ((long) shape.nc * elementBytes), elementBytes));
+    shape.mc = (int) min((long) size, max(1L, lastLevel / 2 / ((long) shape.kc * elementBytes)));
+    return shape;
+}
+
+template <typename T>
+void multiplyMatrices_Tiled(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C, TileShape tile)
+{
+    int size = C.rows();
+    C.setZero();
+    for (int jj = 0; jj < size; jj += tile.nc) {
+        int jEnd = min(jj + tile.nc, size);
+        for (int kk = 0; kk < size; kk += tile.kc) {
+            int kEnd = min(kk + tile.kc, size);
+            for (int ii = 0; ii < size; ii += tile.mc) {
+                int iEnd = min(ii + tile.mc, size);
+                for (int i = ii; i < iEnd; i++) {
+                    T *c = C[i];
+                    for (int k = kk; k < kEnd; k++) {
+                        T a = A[i][k];
+                        const T *b = B[k];
+                        for (int j = jj; j < jEnd; j++)
+                            c[j] += a * b[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Packed GEMM with register-blocked micro-kernels. A kc-deep slice of A is
+// copied into MR-row micro-panels and one of B into NR-column micro-panels,
+// both zero padded, so a micro-kernel reads two contiguous streams and keeps
+// its whole MR x NR block of C in registers for the kc steps.
+//
+// Micro-kernel contract: a holds kc columns of MR values, b kc rows of NR
+// values; the MR x NR product is added to c, whose rows are ldc apart.
+// ----------------------------------------------------------------------------
+
+// Ids are shared with Kotlin, append only
+enum MicroKernelType {
+    KERNEL_FLOAT32 = 0,    // 8x8
+    KERNEL_INT32,          // 4x4
+    KERNEL_INT64,          // 4x4
+    KERNEL_TYPE_COUNT
+};
+
+// Accumulators in a local array the compiler keeps in registers. The int64
+// kernel always uses it: neither NEON nor SSE/AVX2 has a 64-bit lane multiply.
+template <typename Element, int Rows, int Cols>
+struct ScalarMicroKernel {
+    typedef Element T;
+    static const int MR = Rows;
+    static const int NR = Cols;
+
+    static const char *name() { return "scalar"; }
+    static void run(int kc, const T *a, const T *b, T *c, int ldc)
+    {
+        T acc[MR][NR] = {};
+        for (int p = 0; p < kc; p++, a += MR, b += NR) {
+            for (int r = 0; r < MR; r++) {
+                for (int j = 0; j < NR; j++)
+                    acc[r][j] += a[r] * b[j];
+            }
+        }
+        for (int r = 0; r < MR; r++) {
+            for (int j = 0; j < NR; j++)
+                c[r * ldc + j] += acc[r][j];
+        }
+    }
+};
+
+#if defined(__ARM_NEON)
+struct NeonFloat8x8 {
+    typedef float T;
+    static const int MR = 8;
+    static const int NR = 8;
+
+    static const char *name() { return "NEON"; }
+    static void run(int kc, const float *a, const float *b, float *c, int ldc)
+    {
+        // 16 accumulators, 2 B registers, 1 broadcast: fits the 32 registers of
+        // AArch64; ARMv7 has 16 and spills some
+        float32x4_t acc[8][2];
+        for (int r = 0; r < 8; r++)
+            acc[r][0] = acc[r][1] = vdupq_n_f32(0);
+        for (int p = 0; p < kc; p++, a += 8, b += 8) {
+            float32x4_t b0 = vld1q_f32(b);
+            float32x4_t b1 = vld1q_f32(b + 4);
+            for (int r = 0; r < 8; r++) {
+                float32x4_t ar = vdupq_n_f32(a[r]);
+#if defined(__aarch64__)
+                acc[r][0] = vfmaq_f32(acc[r][0], ar, b0);
+                acc[r][1] = vfmaq_f32(acc[r][1], ar, b1);
+#else
+                acc[r][0] = vmlaq_f32(acc[r][0], ar, b0);
+                acc[r][1] = vmlaq_f32(acc[r][1], ar, b1);
+#endif
+            }
+        }
+        for (int r = 0; r < 8; r++, c += ldc) {
+            vst1q_f32(c, vaddq_f32(vld1q_f32(c), acc[r][0]));
+            vst1q_f32(c + 4, vaddq_f32(vld1q_f32(c + 4), acc[r][1]));
+        }
+    }
+};
+
+struct NeonInt32x4x4 {
+    typedef int32_t T;
+    static const int MR = 4;
+    static const int NR = 4;
+
+    static const char *name() { return "NEON"; }
+    static void run(int kc, const int32_t *a, const int32_t *b, int32_t *c, int ldc)
+    {
+        int32x4_t acc[4];
+        for (int r = 0; r < 4; r++)
+            acc[r] = vdupq_n_s32(0);
+        for (int p = 0; p < kc; p++, a += 4, b += 4) {
+            int32x4_t bv = vld1q_s32(b);
+            for (int r = 0; r < 4; r++)
+                acc[r] = vmlaq_n_s32(acc[r], bv, a[r]);
+        }
+        for (int r = 0; r < 4; r++, c += ldc)
+            vst1q_s32(c, vaddq_s32(vld1q_s32(c), acc[r]));
+    }
+};
+#endif
+
+#if defined(__SSE2__)
+struct SseFloat8x8 {
+    typedef float T;
+    static const int MR = 8;
+    static const int NR = 8;
+
+    static const char *name() { return "SSE"; }
+    static void run(int kc, const float *a, const float *b, float *c, int ldc)
+    {
+        __m128 acc[8][2];
+        for (int r = 0; r < 8; r++)
+            acc[r][0] = acc[r][1] = _mm_setzero_ps();
+        for (int p = 0; p < kc; p++, a += 8, b += 8) {
+            __m128 b0 = _mm_loadu_ps(b);
+            __m128 b1 = _mm_loadu_ps(b + 4);
+            for (int r = 0; r < 8; r++) {
+                __m128 ar = _mm_set1_ps(a[r]);
+                acc[r][0] = _mm_add_ps(acc[r][0], _mm_mul_ps(ar, b0));
+                acc[r][1] = _mm_add_ps(acc[r][1], _mm_mul_ps(ar, b1));
+            }
+        }
+        for (int r = 0; r < 8; r++, c += ldc) {
+            _mm_storeu_ps(c, _mm_add_ps(_mm_loadu_ps(c), acc[r][0]));
+            _mm_storeu_ps(c + 4, _mm_add_ps(_mm_loadu_ps(c + 4), acc[r][1]));
+        }
+    }
+};
+#endif
+
+#if defined(__SSE4_1__)
+struct SseInt32x4x4 {
+    typedef int32_t T;
+    static const int MR = 4;
+    static const int NR = 4;
 
-    long **C = (long **) calloc(cacheSize, sizeof(long *));
-    for (int i = 0; i < cacheSize; i++)
-        C[i] = (long *) calloc(cacheSize, sizeof(long));
+    static const char *name() { return "SSE4.1"; }
+    static void run(int kc, const int32_t *a, const int32_t *b, int32_t *c, int ldc)
+    {
+        __m128i acc[4];
+        for (int r = 0; r < 4; r++)
+            acc[r] = _mm_setzero_si128();
+        for (int p = 0; p < kc; p++, a += 4, b += 4) {
+            __m128i bv = _mm_loadu_si128((const __m128i *) b);
+            for (int r = 0; r < 4; r++)
+                acc[r] = _mm_add_epi32(acc[r], _mm_mullo_epi32(_mm_set1_epi32(a[r]), bv));
+        }
+        for (int r = 0; r < 4; r++, c += ldc) {
+            __m128i *row = (__m128i *) c;
+            _mm_storeu_si128(row, _mm_add_epi32(_mm_loadu_si128(row), acc[r]));
+        }
+    }
+};
+#endif
+
+#if defined(__AVX__)
+struct AvxFloat8x8 {
+    typedef float T;
+    static const int MR = 8;
+    static const int NR = 8;
 
-    mt19937 gen(12345);
-    uniform_int_distribution<int> dis(1, 100);
-    for(int i=0; i< cacheSize; i++)
+    static const char *name() { return "AVX"; }
+    static void run(int kc, const float *a, const float *b, float *c, int ldc)
     {
-        for(int j=0; j<cacheSize; j++)
-        {
-            A[i][j] = dis(gen);
-            B[i][j] = dis(gen);
+        __m256 acc[8];
+        for (int r = 0; r < 8; r++)
+            acc[r] = _mm256_setzero_ps();
+        for (int p = 0; p < kc; p++, a += 8, b += 8) {
+            __m256 bv = _mm256_loadu_ps(b);
+            for (int r = 0; r < 8; r++) {
+#if defined(__FMA__)
+                acc[r] = _mm256_fmadd_ps(_mm256_set1_ps(a[r]), bv, acc[r]);
+#else
+                acc[r] = _mm256_add_ps(acc[r], _mm256_mul_ps(_mm256_set1_ps(a[r]), bv));
+#endif
+            }
         }
+        for (int r = 0; r < 8; r++, c += ldc)
+            _mm256_storeu_ps(c, _mm256_add_ps(_mm256_loadu_ps(c), acc[r]));
     }
+};
+#endif
+
+// Widest kernels this build was compiled for
+#if defined(__AVX__)
+typedef AvxFloat8x8 NativeFloatKernel;
+#elif defined(__SSE2__)
+typedef SseFloat8x8 NativeFloatKernel;
+#elif defined(__ARM_NEON)
+typedef NeonFloat8x8 NativeFloatKernel;
+#else
+typedef ScalarMicroKernel<float, 8, 8> NativeFloatKernel;
+#endif
+
+#if defined(__SSE4_1__)
+typedef SseInt32x4x4 NativeInt32Kernel;
+#elif defined(__ARM_NEON)
+typedef NeonInt32x4x4 NativeInt32Kernel;
+#else
+typedef ScalarMicroKernel<int32_t, 4, 4> NativeInt32Kernel;
+#endif
+
+typedef ScalarMicroKernel<int64_t, 4, 4> NativeInt64Kernel;
+
+// Block sizes for the packed kernel, half of each level again:
+//   L1: one kc x MR micro-panel of A and one kc x NR micro-panel of B
+//   L2: the packed mc x kc block of A
+//   L3: the packed kc x nc block of B (L2 without an L3)
+// Clamped to the matrix like tileShapeForCaches, mc and nc to whole
+// micro-panels, so a small matrix does not pack into megabyte panels.
+static TileShape packedTileShape(const CacheSizes &caches, int elementBytes, int mr, int nr, int size)
+{
+    long lastLevel = caches.l3 > 0 ? caches.l3 : caches.l2;
+    size = max(1, size);
+    long mcLimit = (size + mr - 1) / mr * mr;
+    long ncLimit = (size + nr - 1) / nr * nr;
+    TileShape shape;
+    shape.kc = (int) min((long) size, max(1L, caches.l1 / 2 / ((mr + nr) * elementBytes)));
+    shape.mc = (int) min(mcLimit, max((long) mr, caches.l2 / 2 / ((long) shape.kc * elementBytes) / mr * mr));
+    shape.nc = (int) min(ncLimit, max((long) nr, lastLevel / 2 / ((long) shape.kc * elementBytes) / nr * nr));
+    return shape;
+}
+
+// Packing buffers for one tile shape, allocated before the timed region
+template <class Kernel>
+struct PackedPanels {
+    vector<typename Kernel::T> a;
+    vector<typename Kernel::T> b;
+
+    explicit PackedPanels(TileShape tile)
+        : a((size_t) (tile.mc + Kernel::MR - 1) / Kernel::MR * Kernel::MR * tile.kc),
+          b((size_t) (tile.nc + Kernel::NR - 1) / Kernel::NR * Kernel::NR * tile.kc) {}
+};
+
+template <class Kernel>
+static void packA(const Matrix<typename Kernel::T> &A, int ic, int pc, int mc, int kc, typename Kernel::T *packed)
+{
+    for (int ir = 0; ir < mc; ir += Kernel::MR) {
+        for (int p = 0; p < kc; p++) {
+            for (int r = 0; r < Kernel::MR; r++)
+                *packed++ = ir + r < mc ? A[ic + ir + r][pc + p] : 0;
+        }
+    }
+}
+
+template <class Kernel>
+static void packB(const Matrix<typename Kernel::T> &B, int pc, int jc, int kc, int nc, typename Kernel::T *packed)
+{
+    for (int jr = 0; jr < nc; jr += Kernel::NR) {
+        for (int p = 0; p < kc; p++) {
+            const typename Kernel::T *row = B[pc + p] + jc + jr;
+            for (int j = 0; j < Kernel::NR; j++)
+                *packed++ = jr + j < nc ? row[j] : 0;
+        }
+    }
+}
+
+template <class Kernel>
+void multiplyMatrices_Packed(const Matrix<typename Kernel::T> &A, const Matrix<typename Kernel::T> &B,
+                             Matrix<typename Kernel::T> &C, TileShape tile, PackedPanels<Kernel> &panels)
+{
+    typedef typename Kernel::T T;
+    const int MR = Kernel::MR, NR = Kernel::NR;
+    int size = C.rows();
+    C.setZero();
+
+    vector<T> &packedA = panels.a;
+    vector<T> &packedB = panels.b;
+    T edge[MR * NR];
+
+    for (int jc = 0; jc < size; jc += tile.nc) {
+        int nc = min(tile.nc, size - jc);
+        for (int pc = 0; pc < size; pc += tile.kc) {
+            int kc = min(tile.kc, size - pc);
+            packB<Kernel>(B, pc, jc, kc, nc, packedB.data());
+            for (int ic = 0; ic < size; ic += tile.mc) {
+                int mc = min(tile.mc, size - ic);
+                packA<Kernel>(A, ic, pc, mc, kc, packedA.data());
+                for (int jr = 0; jr < nc; jr += NR) {
+                    const T *b = packedB.data() + (size_t) jr * kc;
+                    for (int ir = 0; ir < mc; ir += MR) {
+                        const T *a = packedA.data() + (size_t) ir * kc;
+                        if (ir + MR <= mc && jr + NR <= nc) {
+                            Kernel::run(kc, a, b, C[ic + ir] + jc + jr, C.stride());
+                            continue;
+                        }
+                        // Edge block: full micro-kernel into a scratch tile, keep the valid part
+                        fill(edge, edge + MR * NR, (T) 0);
+                        Kernel::run(kc, a, b, edge, NR);
+                        for (int r = 0; r < min(MR, mc - ir); r++) {
+                            for (int j = 0; j < min(NR, nc - jr); j++)
+                                C[ic + ir + r][jc + jr + j] += edge[r * NR + j];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+static bool matricesAgree(const Matrix<T> &X, const Matrix<T> &Y)
+{
+    return X == Y;
+}
+
+// Float sums are exact only while they stay below 2^24, past that the two
+// summation orders may round differently
+static bool matricesAgree(const Matrix<float> &X, const Matrix<float> &Y)
+{
+    for (int i = 0; i < X.rows(); i++) {
+        for (int j = 0; j < X.cols(); j++) {
+            if (fabs(X[i][j] - Y[i][j]) > 1e-5f * fabs(X[i][j]))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Appends [type, IJK seconds, packed seconds, IJK GOP/s, packed GOP/s, 1 if
+// the products agree]; one multiply-add counts as two operations
+template <class Kernel>
+static void appendMicroKernelRow(int type, int size, const CacheSizes &caches, vector<double> &report)
+{
+    typedef typename Kernel::T T;
+    TileShape tile = packedTileShape(caches, sizeof(T), Kernel::MR, Kernel::NR, size);
+    PackedPanels<Kernel> panels(tile);
+    Matrix<T> A(size, size), B(size, size), C_IJK(size, size), C_Packed(size, size);
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
 
     auto start1 = high_resolution_clock::now();
-    multiplyMatrices_IJK(A, B, C, cacheSize);
+    multiplyMatrices_IJK(A, B, C_IJK);
     auto end1 = high_resolution_clock::now();
 
-    for(int i = 0; i<cacheSize;i++)
-    {
-        for(int j=0; j< cacheSize; j++)
-        {
-            C[i][j] = 0;
+    auto start2 = high_resolution_clock::now();
+    multiplyMatrices_Packed<Kernel>(A, B, C_Packed, tile, panels);
+    auto end2 = high_resolution_clock::now();
+
+    bool matches = matricesAgree(C_IJK, C_Packed);
+    if (!matches)
+        LOGE("%s %dx%d micro-kernel disagrees with IJK", Kernel::name(), Kernel::MR, Kernel::NR);
+
+    duration<double> time1 = end1 - start1;
+    duration<double> time2 = end2 - start2;
+    double giga = 2.0 * size * size * size / 1e9;
+    report.insert(report.end(), {(double) type, time1.count(), time2.count(), giga / time1.count(),
+                                 giga / time2.count(), matches ? 1.0 : 0.0});
+    LOGI("%s %dx%d, tiles mc %d kc %d nc %d: %.2f GOP/s, IJK %.2f GOP/s", Kernel::name(), Kernel::MR,
+         Kernel::NR, tile.mc, tile.kc, tile.nc, giga / time2.count(), giga / time1.count());
+}
+
+// ----------------------------------------------------------------------------
+// Multi-threaded GEMM. C is cut into 2D tiles that the threads take from a
+// shared counter, so a big core simply ends up with more tiles than a little
+// one. Every tile runs the cache-blocked loop over its own rows and columns.
+// ----------------------------------------------------------------------------
+
+// Tiles per thread: enough to balance cores of different speeds
+static const int TILES_PER_THREAD = 4;
+static const int MIN_TILE_EDGE = 16;
+
+template <typename T>
+static void multiplyTile(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C, int i0, int i1, int j0, int j1, int kc)
+{
+    int size = C.rows();
+    for (int i = i0; i < i1; i++)
+        fill(C[i] + j0, C[i] + j1, (T) 0);
+    for (int kk = 0; kk < size; kk += kc) {
+        int kEnd = min(kk + kc, size);
+        for (int i = i0; i < i1; i++) {
+            T *c = C[i];
+            for (int k = kk; k < kEnd; k++) {
+                T a = A[i][k];
+                const T *b = B[k];
+                for (int j = j0; j < j1; j++)
+                    c[j] += a * b[j];
+            }
+        }
+    }
+}
+
+// Square tiles, at least TILES_PER_THREAD per thread, no wider than the
+// cache-derived nc. Columns round up to whole cache lines so neighbouring
+// threads never write the same line of a C row (rows start line-aligned)
+static void parallelTileEdges(int size, int threadCount, const TileShape &cacheTile, int elementBytes,
+                              int &tileRows, int &tileCols)
+{
+    int perSide = (int) ceil(sqrt((double) threadCount * TILES_PER_THREAD));
+    int edge = max(MIN_TILE_EDGE, (size + perSide - 1) / perSide);
+    int perLine = max(1, MATRIX_ALIGNMENT / elementBytes);
+    tileRows = edge;
+    tileCols = (min(edge, cacheTile.nc) + perLine - 1) / perLine * perLine;
+}
+
+// Runs on threadCount new threads, each restricted to cpus (no pinning when
+// cpus is empty)
+template <typename T>
+void multiplyMatrices_Parallel(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C, int threadCount,
+                               const vector<int> &cpus, const TileShape &cacheTile)
+{
+    int size = C.rows();
+    int tileRows, tileCols;
+    parallelTileEdges(size, threadCount, cacheTile, sizeof(T), tileRows, tileCols);
+    int tilesDown = (size + tileRows - 1) / tileRows;
+    int tilesAcross = (size + tileCols - 1) / tileCols;
+    int tileCount = tilesDown * tilesAcross;
+
+    atomic<int> nextTile(0);
+    vector<thread> workers;
+    workers.reserve(threadCount);
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&]() {
+            if (!cpus.empty() && !pinCurrentThread(cpus))
+                LOGE("Could not pin a GEMM thread");
+            for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+                int i0 = tile / tilesAcross * tileRows;
+                int j0 = tile % tilesAcross * tileCols;
+                multiplyTile(A, B, C, i0, min(i0 + tileRows, size), j0, min(j0 + tileCols, size), cacheTile.kc);
+            }
+        });
+    }
+    for (thread &worker : workers)
+        worker.join();
+}
+
+// ----------------------------------------------------------------------------
+// Cache-oblivious recursive GEMM and Strassen. Both work on views into
+// Matrix storage: the recursion halves the largest of m, n and k, so some
+// level fits every cache without knowing its size. Strassen trades one of
+// the eight half-size products for 18 additions per level.
+// ----------------------------------------------------------------------------
+
+// Below this many multiply-adds the recursion hands over to the IKJ loop
+static const long RECURSIVE_LEAF_WORK = 32L * 32 * 32;
+static const int STRASSEN_CUTOFFS[] = {16, 32, 64, 128, 256};
+// Largest size the Strassen cutoff is tuned on
+static const int STRASSEN_TUNING_SIZE = 512;
+
+template <typename T>
+struct MatrixView {
+    T *data;
+    int stride;
+
+    T *operator[](int i) const { return data + (size_t) i * stride; }
+    MatrixView block(int i, int j) const { return {data + (size_t) i * stride + j, stride}; }
+};
+
+template <typename T>
+static MatrixView<T> viewOf(Matrix<T> &M) { return {M.data(), M.stride()}; }
+template <typename T>
+static MatrixView<const T> viewOf(const Matrix<T> &M) { return {M.data(), M.stride()}; }
+
+// C (m x n) += A (m x k) * B (k x n)
+template <typename T>
+static void multiplyRecursive(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C, int m, int n, int k)
+{
+    if ((long) m * n * k <= RECURSIVE_LEAF_WORK) {
+        for (int i = 0; i < m; i++) {
+            T *c = C[i];
+            for (int p = 0; p < k; p++) {
+                T a = A[i][p];
+                const T *b = B[p];
+                for (int j = 0; j < n; j++)
+                    c[j] += a * b[j];
+            }
+        }
+        return;
+    }
+    if (m >= n && m >= k) {
+        int h = m / 2;
+        multiplyRecursive(A, B, C, h, n, k);
+        multiplyRecursive(A.block(h, 0), B, C.block(h, 0), m - h, n, k);
+    } else if (n >= k) {
+        int h = n / 2;
+        multiplyRecursive(A, B, C, m, h, k);
+        multiplyRecursive(A, B.block(0, h), C.block(0, h), m, n - h, k);
+    } else {
+        int h = k / 2;
+        multiplyRecursive(A, B, C, m, n, h);
+        multiplyRecursive(A.block(0, h), B.block(h, 0), C, m, n, k - h);
+    }
+}
+
+template <typename T>
+void multiplyMatrices_Recursive(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C)
+{
+    int size = C.rows();
+    C.setZero();
+    multiplyRecursive(viewOf(A), viewOf(B), viewOf(C), size, size, size);
+}
+
+// out = X + sign * Y on n x n blocks
+template <typename T>
+static void addBlocks(MatrixView<const T> X, MatrixView<const T> Y, int sign, MatrixView<T> out, int n)
+{
+    for (int i = 0; i < n; i++) {
+        const T *x = X[i];
+        const T *y = Y[i];
+        T *o = out[i];
+        for (int j = 0; j < n; j++)
+            o[j] = sign > 0 ? x[j] + y[j] : x[j] - y[j];
+    }
+}
+
+// out = P or out += sign * P on n x n blocks
+template <typename T>
+static void storeBlock(MatrixView<const T> P, MatrixView<T> out, int sign, int n)
+{
+    for (int i = 0; i < n; i++) {
+        const T *p = P[i];
+        T *o = out[i];
+        for (int j = 0; j < n; j++)
+            o[j] = sign == 0 ? p[j] : sign > 0 ? o[j] + p[j] : o[j] - p[j];
+    }
+}
+
+// C = A * B for n x n blocks, n a power-of-two multiple of a size <= cutoff
+template <typename T>
+static void strassen(MatrixView<const T> A, MatrixView<const T> B, MatrixView<T> C, int n, int cutoff)
+{
+    if (n <= cutoff || n % 2 != 0) {
+        for (int i = 0; i < n; i++)
+            fill(C[i], C[i] + n, (T) 0);
+        multiplyRecursive(A, B, C, n, n, n);
+        return;
+    }
+    int h = n / 2;
+    MatrixView<const T> A11 = A, A12 = A.block(0, h), A21 = A.block(h, 0), A22 = A.block(h, h);
+    MatrixView<const T> B11 = B, B12 = B.block(0, h), B21 = B.block(h, 0), B22 = B.block(h, h);
+    MatrixView<T> C11 = C, C12 = C.block(0, h), C21 = C.block(h, 0), C22 = C.block(h, h);
+
+    Matrix<T> left(h, h), right(h, h), product(h, h);
+    MatrixView<T> L = viewOf(left), R = viewOf(right), P = viewOf(product);
+    MatrixView<const T> Lc = viewOf((const Matrix<T> &) left), Rc = viewOf((const Matrix<T> &) right);
+    MatrixView<const T> Pc = viewOf((const Matrix<T> &) product);
+
+    // M1 = (A11 + A22)(B11 + B22)          C11 = M1, C22 = M1
+    addBlocks(A11, A22, 1, L, h);
+    addBlocks(B11, B22, 1, R, h);
+    strassen(Lc, Rc, P, h, cutoff);
+    storeBlock(Pc, C11, 0, h);
+    storeBlock(Pc, C22, 0, h);
+    // M2 = (A21 + A22) B11                 C21 = M2, C22 -= M2
+    addBlocks(A21, A22, 1, L, h);
+    strassen(Lc, B11, P, h, cutoff);
+    storeBlock(Pc, C21, 0, h);
+    storeBlock(Pc, C22, -1, h);
+    // M3 = A11 (B12 - B22)                 C12 = M3, C22 += M3
+    addBlocks(B12, B22, -1, R, h);
+    strassen(A11, Rc, P, h, cutoff);
+    storeBlock(Pc, C12, 0, h);
+    storeBlock(Pc, C22, 1, h);
+    // M4 = A22 (B21 - B11)                 C11 += M4, C21 += M4
+    addBlocks(B21, B11, -1, R, h);
+    strassen(A22, Rc, P, h, cutoff);
+    storeBlock(Pc, C11, 1, h);
+    storeBlock(Pc, C21, 1, h);
+    // M5 = (A11 + A12) B22                 C11 -= M5, C12 += M5
+    addBlocks(A11, A12, 1, L, h);
+    strassen(Lc, B22, P, h, cutoff);
+    storeBlock(Pc, C11, -1, h);
+    storeBlock(Pc, C12, 1, h);
+    // M6 = (A21 - A11)(B11 + B12)          C22 += M6
+    addBlocks(A21, A11, -1, L, h);
+    addBlocks(B11, B12, 1, R, h);
+    strassen(Lc, Rc, P, h, cutoff);
+    storeBlock(Pc, C22, 1, h);
+    // M7 = (A12 - A22)(B21 + B22)          C11 += M7
+    addBlocks(A12, A22, -1, L, h);
+    addBlocks(B21, B22, 1, R, h);
+    strassen(Lc, Rc, P, h, cutoff);
+    storeBlock(Pc, C11, 1, h);
+}
+
+// Pads to leaf * 2^levels with the smallest leaf <= cutoff, so at most
+// 2^levels - 1 zero rows and columns are added
+template <typename T>
+void multiplyMatrices_Strassen(const Matrix<T> &A, const Matrix<T> &B, Matrix<T> &C, int cutoff)
+{
+    int size = C.rows();
+    int levels = 0;
+    while (((size + (1 << levels) - 1) >> levels) > cutoff)
+        levels++;
+    int padded = ((size + (1 << levels) - 1) >> levels) << levels;
+
+    Matrix<T> paddedA(padded, padded), paddedB(padded, padded), paddedC(padded, padded);
+    for (int i = 0; i < size; i++) {
+        copy(A[i], A[i] + size, paddedA[i]);
+        copy(B[i], B[i] + size, paddedB[i]);
+    }
+    strassen(viewOf((const Matrix<T> &) paddedA), viewOf((const Matrix<T> &) paddedB), viewOf(paddedC), padded, cutoff);
+    for (int i = 0; i < size; i++)
+        copy(paddedC[i], paddedC[i] + size, C[i]);
+}
+
+// Fastest STRASSEN_CUTOFFS entry on a probe of min(size, STRASSEN_TUNING_SIZE)
+static int tuneStrassenCutoff(int size)
+{
+    int probe = max(1, min(size, STRASSEN_TUNING_SIZE));
+    Matrix<int64_t> A(probe, probe), B(probe, probe), C(probe, probe);
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
+
+    int best = STRASSEN_CUTOFFS[0];
+    double bestSeconds = -1;
+    for (int cutoff : STRASSEN_CUTOFFS) {
+        auto start = high_resolution_clock::now();
+        multiplyMatrices_Strassen(A, B, C, cutoff);
+        duration<double> elapsed = high_resolution_clock::now() - start;
+        if (bestSeconds < 0 || elapsed.count() < bestSeconds) {
+            bestSeconds = elapsed.count();
+            best = cutoff;
         }
     }
+    return best;
+}
+
+static string jstringToStdString(JNIEnv *env, jstring value)
+{
+    const char *chars = env->GetStringUTFChars(value, NULL);
+    string result(chars);
+    env->ReleaseStringUTFChars(value, chars);
+    return result;
+}
+
+// Times IJK then IKJ on size x size matrices laid out with the given row
+// padding. Returns [IJK seconds, IKJ seconds, 1 if both C match]
+static vector<double> runMatrixKernels(int size, int padding, bool alignRows)
+{
+    Matrix<long> A(size, size, padding, alignRows);
+    Matrix<long> B(size, size, padding, alignRows);
+    Matrix<long> C_IJK(size, size, padding, alignRows);
+    Matrix<long> C_IKJ(size, size, padding, alignRows);
+
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
+
+    auto start1 = high_resolution_clock::now();
+    multiplyMatrices_IJK(A, B, C_IJK);
+    auto end1 = high_resolution_clock::now();
 
     auto start2 = high_resolution_clock::now();
-    multiplyMatrices_IKJ(A, B, C, cacheSize);
+    multiplyMatrices_IKJ(A, B, C_IKJ);
     auto end2 = high_resolution_clock::now();
 
+    bool matches = C_IJK == C_IKJ;
+    if (!matches)
+        LOGE("IJK and IKJ disagree on a %dx%d product", size, size);
+
     duration<double> time1 = end1 - start1;
     duration<double> time2 = end2 - start2;
+    return {time1.count(), time2.count(), matches ? 1.0 : 0.0};
+}
+
+static jdoubleArray toJavaDoubleArray(JNIEnv *env, const vector<double> &values)
+{
+    jdoubleArray result = env->NewDoubleArray(values.size());
+    env->SetDoubleArrayRegion(result, 0, values.size(), values.data());
+    return result;
+}
+
+// [IJK seconds, IKJ seconds, 1 if both produced the same C], rows start on
+// cache lines
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runMatrixBenchmark(JNIEnv *env, jobject, jlong cacheSize) {
+    return toJavaDoubleArray(env, runMatrixKernels(cacheSize, 0, true));
+}
+
+// Same report with an explicit layout: padding extra elements per row, rows
+// packed back to back when alignRows is false
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runMatrixLayoutBenchmark(JNIEnv *env, jobject, jint size,
+                                                                                  jint padding, jboolean alignRows) {
+    return toJavaDoubleArray(env, runMatrixKernels(size, max(0, (int) padding), alignRows));
+}
+
+// IKJ against the tiled kernel with the tile shape this device's caches
+// give for 8-byte elements. Returns [IKJ seconds, tiled seconds, mc, kc, nc,
+// 1 if both produced the same C]
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runTiledMatrixBenchmark(JNIEnv *env, jobject, jstring hardware,
+                                                                                 jstring board, jint size) {
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+    TileShape tile = tileShapeForCaches(caches, sizeof(long), size);
+
+    Matrix<long> A(size, size), B(size, size), C_IKJ(size, size), C_Tiled(size, size);
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
+
+    auto start1 = high_resolution_clock::now();
+    multiplyMatrices_IKJ(A, B, C_IKJ);
+    auto end1 = high_resolution_clock::now();
+
+    auto start2 = high_resolution_clock::now();
+    multiplyMatrices_Tiled(A, B, C_Tiled, tile);
+    auto end2 = high_resolution_clock::now();
+
+    bool matches = C_IKJ == C_Tiled;
+    if (!matches)
+        LOGE("Tiled kernel (%d, %d, %d) disagrees with IKJ", tile.mc, tile.kc, tile.nc);
+
+    duration<double> time1 = end1 - start1;
+    duration<double> time2 = end2 - start2;
+    return toJavaDoubleArray(env, {time1.count(), time2.count(), (double) tile.mc, (double) tile.kc,
+                                   (double) tile.nc, matches ? 1.0 : 0.0});
+}
+
+// Times the cache-derived tile shape and its neighbours: mc, kc and nc each
+// halved and doubled, plus square power-of-two tiles from 16 to 256. Returns
+// [index of the fastest row], then rows of [mc, kc, nc, seconds]; row 0 is
+// the cache-derived shape
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runTileSweep(JNIEnv *env, jobject, jstring hardware,
+                                                                      jstring board, jint size) {
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+    TileShape derived = tileShapeForCaches(caches, sizeof(long), size);
 
-    for (int i = 0; i < cacheSize; i++) {
-        free(A[i]);
-        free(B[i]);
-        free(C[i]);
+    vector<TileShape> shapes = {derived};
+    for (int scale : {-1, 1}) {
+        auto scaled = [scale](int v) { return max(1, scale < 0 ? v / 2 : v * 2); };
+        shapes.push_back({scaled(derived.mc), derived.kc, derived.nc});
+        shapes.push_back({derived.mc, scaled(derived.kc), derived.nc});
+        shapes.push_back({derived.mc, derived.kc, scaled(derived.nc)});
     }
-    free(A);
-    free(B);
-    free(C);
+    for (int t = 16; t <= 256; t *= 2)
+        shapes.push_back({t, t, t});
 
-    jdoubleArray  result = env->NewDoubleArray(2);
-    jdouble times[2] = {time1.count(), time2.count()};
-    env->SetDoubleArrayRegion(result, 0, 2, times);
+    Matrix<long> A(size, size), B(size, size), C(size, size), expected(size, size);
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
+    multiplyMatrices_IKJ(A, B, expected);
+
+    vector<double> report = {0};
+    double bestSeconds = -1;
+    for (size_t s = 0; s < shapes.size(); s++) {
+        const TileShape &tile = shapes[s];
+        auto start = high_resolution_clock::now();
+        multiplyMatrices_Tiled(A, B, C, tile);
+        duration<double> elapsed = high_resolution_clock::now() - start;
+        if (!(C == expected))
+            LOGE("Tiled kernel (%d, %d, %d) disagrees with IKJ", tile.mc, tile.kc, tile.nc);
+
+        if (bestSeconds < 0 || elapsed.count() < bestSeconds) {
+            bestSeconds = elapsed.count();
+            report[0] = s;
+        }
+        report.insert(report.end(), {(double) tile.mc, (double) tile.kc, (double) tile.nc, elapsed.count()});
+    }
+    LOGI("Best tile for %dx%d: mc %d, kc %d, nc %d", size, size, shapes[report[0]].mc,
+         shapes[report[0]].kc, shapes[report[0]].nc);
+    return toJavaDoubleArray(env, report);
+}
+
+// Names of the micro-kernels this build uses, indexed by MicroKernelType
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_getMicroKernelNames(JNIEnv *env, jobject) {
+    string names[KERNEL_TYPE_COUNT] = {
+            string(NativeFloatKernel::name()) + " 8x8 float32",
+            string(NativeInt32Kernel::name()) + " 4x4 int32",
+            string(NativeInt64Kernel::name()) + " 4x4 int64",
+    };
+    jclass stringClass = env->FindClass("java/lang/String");
+    jobjectArray result = env->NewObjectArray(KERNEL_TYPE_COUNT, stringClass, NULL);
+    for (int t = 0; t < KERNEL_TYPE_COUNT; t++) {
+        jstring name = env->NewStringUTF(names[t].c_str());
+        env->SetObjectArrayElement(result, t, name);
+        env->DeleteLocalRef(name);
+    }
     return result;
 }
 
+// Packed micro-kernel GEMM against the naive IJK loop for every
+// MicroKernelType. Returns rows of [type, IJK seconds, packed seconds,
+// IJK GOP/s, packed GOP/s, 1 if the products agree]
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runMicroKernelBenchmark(JNIEnv *env, jobject, jstring hardware,
+                                                                                 jstring board, jint size) {
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+    vector<double> report;
+    appendMicroKernelRow<NativeFloatKernel>(KERNEL_FLOAT32, size, caches, report);
+    appendMicroKernelRow<NativeInt32Kernel>(KERNEL_INT32, size, caches, report);
+    appendMicroKernelRow<NativeInt64Kernel>(KERNEL_INT64, size, caches, report);
+    return toJavaDoubleArray(env, report);
+}
+
+// Parallel tiled GEMM on 1..maxThreads threads restricted to a CoreCluster.
+// Returns [CPUs in the cluster], then rows of [threads, seconds, speedup over
+// one thread, scaling efficiency (speedup / threads), 1 if C matches IKJ];
+// NULL when the cluster has no CPUs. More threads than CPUs share them.
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runParallelMatrixBenchmark(JNIEnv *env, jobject, jstring hardware,
+                                                                                    jstring board, jint size,
+                                                                                    jint maxThreads, jint cluster) {
+    vector<int> cpus = getClusterCpus(cluster);
+    if (cpus.empty()) {
+        LOGE("Core cluster %d has no CPUs", cluster);
+        return NULL;
+    }
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+    TileShape cacheTile = tileShapeForCaches(caches, sizeof(long), size);
+
+    Matrix<long> A(size, size), B(size, size), C(size, size), expected(size, size);
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
+    multiplyMatrices_IKJ(A, B, expected);
+
+    vector<double> report = {(double) cpus.size()};
+    double oneThreadSeconds = 0;
+    for (int threads = 1; threads <= max(1, (int) maxThreads); threads++) {
+        auto start = high_resolution_clock::now();
+        multiplyMatrices_Parallel(A, B, C, threads, cpus, cacheTile);
+        duration<double> elapsed = high_resolution_clock::now() - start;
 
+        bool matches = C == expected;
+        if (!matches)
+            LOGE("Parallel GEMM on %d threads disagrees with IKJ", threads);
+        if (threads == 1)
+            oneThreadSeconds = elapsed.count();
+        double speedup = oneThreadSeconds / elapsed.count();
+        report.insert(report.end(), {(double) threads, elapsed.count(), speedup, speedup / threads,
+                                     matches ? 1.0 : 0.0});
+    }
+    return toJavaDoubleArray(env, report);
+}
+
+// Naive IJK, cache-blocked, cache-oblivious recursive and Strassen on one
+// size of int64_t, wide enough on every ABI for Strassen's sums and
+// differences to stay exact. Returns [IJK seconds, tiled seconds, recursive
+// seconds, Strassen seconds, tuned Strassen cutoff, 1 if every product
+// matches IJK]; the cutoff tuning is not part of the Strassen time.
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_runRecursiveMatrixBenchmark(JNIEnv *env, jobject, jstring hardware,
+                                                                                     jstring board, jint size) {
+    CacheSizes caches = lookupCacheSizes(jstringToStdString(env, hardware), jstringToStdString(env, board));
+    TileShape tile = tileShapeForCaches(caches, sizeof(int64_t), size);
+    int cutoff = tuneStrassenCutoff(size);
+
+    Matrix<int64_t> A(size, size), B(size, size), C_IJK(size, size), C(size, size);
+    fillUniformMatrix(A, 1, 100, 12345);
+    fillUniformMatrix(B, 1, 100, 54321);
+
+    auto start = high_resolution_clock::now();
+    multiplyMatrices_IJK(A, B, C_IJK);
+    duration<double> ijk = high_resolution_clock::now() - start;
+
+    bool matches = true;
+    auto check = [&](const char *name) {
+        if (!(C == C_IJK)) {
+            LOGE("%s multiplication disagrees with IJK on %dx%d", name, size, size);
+            matches = false;
+        }
+    };
+
+    start = high_resolution_clock::now();
+    multiplyMatrices_Tiled(A, B, C, tile);
+    duration<double> tiled = high_resolution_clock::now() - start;
+    check("Tiled");
+
+    start = high_resolution_clock::now();
+    multiplyMatrices_Recursive(A, B, C);
+    duration<double> recursive = high_resolution_clock::now() - start;
+    check("Recursive");
+
+    start = high_resolution_clock::now();
+    multiplyMatrices_Strassen(A, B, C, cutoff);
+    duration<double> strassenTime = high_resolution_clock::now() - start;
+    check("Strassen");
+
+    return toJavaDoubleArray(env, {ijk.count(), tiled.count(), recursive.count(), strassenTime.count(),
+                                   (double) cutoff, matches ? 1.0 : 0.0});
+}
@@ -5,12 +5,16 @@
 #include <vector>
 #include <map>
 #include <cctype>
+#include <cstdlib>
 #include <algorithm> // Necesar pentru transform
 #include <sys/sysinfo.h>
 #include <sys/utsname.h>
 #include <unistd.h>
 #include <android/log.h>
 #include <sys/auxv.h>
+#include <sched.h>
+
+#include "../includes/deviceInfo.hpp"
 
 #define LOG_TAG "NativeBenchmark"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -247,17 +251,61 @@ string getCPUInfo(string& outHardware) {
     return ss.str();
 }
 
-string getMemoryInfo() {
-    stringstream ss;
-    ss << "\n=== MEMORY INFO ===\n";
+// Helper: MemTotal and MemAvailable from /proc/meminfo, in kB
+void readMemInfoKb(long &total, long &avail) {
     ifstream meminfo("/proc/meminfo");
     string line;
-    long total = 0, avail = 0;
+    total = 0;
+    avail = 0;
 
     while(getline(meminfo, line)) {
         if(line.find("MemTotal:") == 0) sscanf(line.c_str(), "MemTotal: %ld kB", &total);
         else if(line.find("MemAvailable:") == 0) sscanf(line.c_str(), "MemAvailable: %ld kB", &avail);
     }
+}
+
+long getMemAvailableKb() {
+    long total, avail;
+    readMemInfoKb(total, avail);
+    return avail;
+}
+
+vector<int> getClusterCpus(int cluster) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return {};
+
+    vector<pair<int, long>> cpus;
+    long slowest = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        long maxFreq = atol(readFile("/sys/devices/system/cpu/cpu" + to_string(cpu) + "/cpufreq/cpuinfo_max_freq").c_str());
+        cpus.push_back({cpu, maxFreq});
+        if (cpus.size() == 1 || maxFreq < slowest) slowest = maxFreq;
+    }
+
+    bool uniform = all_of(cpus.begin(), cpus.end(), [slowest](const pair<int, long>& c) { return c.second == slowest; });
+    vector<int> result;
+    for (const auto& [cpu, maxFreq] : cpus) {
+        bool big = uniform || maxFreq > slowest;
+        if (cluster == CLUSTER_ALL || (cluster == CLUSTER_BIG && big) || (cluster == CLUSTER_LITTLE && !big))
+            result.push_back(cpu);
+    }
+    return result;
+}
+
+bool pinCurrentThread(const vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+string getMemoryInfo() {
+    stringstream ss;
+    ss << "\n=== MEMORY INFO ===\n";
+    long total = 0, avail = 0;
+    readMemInfoKb(total, avail);
     ss << "Total RAM: " << total/1024 << " MB\nAvailable: " << avail/1024 << " MB\n";
     return ss.str();
 }
@@ -368,48 +416,36 @@ Java_com_example_myapplication_DeviceInfo_sentInfoToC(JNIEnv *env, jobject, jstr
 
     return env->NewStringUTF(result.c_str());
 }
-extern "C" JNIEXPORT jlongArray JNICALL
-Java_com_example_myapplication_MemoryPerformanceActivity_getCacheSizeBytes(JNIEnv *env, jobject, jstring jHardware, jstring jBoard)
+CacheSizes lookupCacheSizes(const string& hardware, const string& board)
 {
-    const char *boardCons = env->GetStringUTFChars(jBoard,0);
-    const char *hardwareCons = env->GetStringUTFChars(jHardware,0);
-
-    string board = toLower(string(boardCons));
-    string hardware = toLower(string(hardwareCons));
-
-    env->ReleaseStringUTFChars(jBoard,boardCons);
-    env->ReleaseStringUTFChars(jHardware,hardwareCons);
-
-    long l1Size = 0, l2Size = 0, l3Size = 0;
-    bool found = false;
+    string hw = toLower(hardware);
+    string bd = toLower(board);
 
     // Iterate through Global Database
     for (auto const& [key, val] : socDatabase) {
         // Check if key is inside board or hardware string
-        if (board.find(key) != string::npos || hardware.find(key) != string::npos) {
-            l1Size = parseSmart(val.l1, 1);
-            l2Size = parseSmart(val.l2, 2);
-            l3Size = parseSmart(val.l3, 3);
-            found = true;
-            break;
+        if (bd.find(key) != string::npos || hw.find(key) != string::npos) {
+            return {parseSmart(val.l1, 1), parseSmart(val.l2, 2), parseSmart(val.l3, 3)};
         }
     }
 
-    if (!found) {
-        // Defaults if not in database
-        l1Size = 32 * 1024;
-        l2Size = 512 * 1024; // Fixed 513 typo
-        l3Size = 2 * 1024 * 1024;
-    }
+    // Defaults if not in database
+    return {32 * 1024, 512 * 1024, 2 * 1024 * 1024};
+}
+
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_MemoryPerformanceActivity_getCacheSizeBytes(JNIEnv *env, jobject, jstring jHardware, jstring jBoard)
+{
+    CacheSizes sizes = lookupCacheSizes(jstringToString(env, jHardware), jstringToString(env, jBoard));
 
     jlongArray res = env->NewLongArray(3);
     if(res == NULL) return NULL;
 
     jlong tempBuffer[3];
-    tempBuffer[0] = l1Size;
-    tempBuffer[1] = l2Size;
-    tempBuffer[2] = l3Size;
+    tempBuffer[0] = sizes.l1;
+    tempBuffer[1] = sizes.l2;
+    tempBuffer[2] = sizes.l3;
 
     env->SetLongArrayRegion(res, 0, 3, tempBuffer);
     return res;
-}
\ No newline at end of file
+}
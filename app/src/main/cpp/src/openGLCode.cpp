@@ -26,6 +26,7 @@
 #include "../includes/Animation.h"
 #include "../includes/Animator.h"
 #include "../includes/model_animation.h"
+#include "../includes/sortVisualizer.hpp"
 
 // Logging Macros
 #define LOG_TAG "NativeGL"
@@ -356,6 +357,7 @@ Java_com_example_myapplication_MyGLRenderer_nativeOnSurfaceCreated(
     initShaders();
     initUniforms();
     initFBO();
+    initSortVisualizer(g_assetManager);
 
     LOGI("Surface creation complete. Objects loaded: %s, Shaders loaded: %s",
          g_objectsLoaded ? "YES" : "NO",
@@ -390,6 +392,11 @@ Java_com_example_myapplication_MyGLRenderer_nativeOnDrawFrame(
     // Uncomment to rotate model:
     // g_angleY += 0.5f;
 
+    if (sortVisualizerActive()) {
+        drawSortVisualizer(g_screenWidth, g_screenHeight);
+        return;
+    }
+
     renderScene();
 }
 
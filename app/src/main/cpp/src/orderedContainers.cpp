@@ -0,0 +1,576 @@
+//
+// Ordered containers under a mixed workload: lookups, inserts, erases and
+// short range scans replayed against a sorted vector, std::set, a B+tree with
+// 64-byte nodes and a skiplist. Calling it with container sizes from a few
+// thousand to a few million keys walks the working set from L1 out to DRAM.
+//
+#include <jni.h>
+#include <set>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/dataGenerator.hpp"
+
+#define LOG_TAG "OrderedContainers"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+// Workload mix in percent, the rest are lookups
+static const int INSERT_PERCENT = 20;
+static const int ERASE_PERCENT = 20;
+static const int SCAN_PERCENT = 10;
+static const int RANGE_SCAN_LENGTH = 32;
+
+static const int BTREE_LEAF_KEYS = 14;
+static const int BTREE_INNER_KEYS = 7;
+static const int SKIPLIST_MAX_LEVEL = 24;
+
+// Ids are shared with Kotlin, append only
+enum OrderedContainer {
+    CONTAINER_SORTED_VECTOR = 0,
+    CONTAINER_STD_SET,
+    CONTAINER_BPLUS_TREE,
+    CONTAINER_SKIPLIST,
+    CONTAINER_COUNT
+};
+
+enum ContainerOpKind {
+    OP_LOOKUP = 0,
+    OP_INSERT,
+    OP_ERASE,
+    OP_SCAN,
+};
+
+struct ContainerOp {
+    int kind;
+    int key;
+};
+
+// ----------------------------------------------------------------------------
+// Sorted vector: binary search, every update shifts the tail
+// ----------------------------------------------------------------------------
+
+class SortedVectorSet {
+public:
+    void bulkLoad(const vector<int> &sortedKeys) { keys = sortedKeys; }
+
+    bool contains(int key) const { return binary_search(keys.begin(), keys.end(), key); }
+
+    bool insert(int key)
+    {
+        auto it = lower_bound(keys.begin(), keys.end(), key);
+        if (it != keys.end() && *it == key)
+            return false;
+        keys.insert(it, key);
+        return true;
+    }
+
+    bool erase(int key)
+    {
+        auto it = lower_bound(keys.begin(), keys.end(), key);
+        if (it == keys.end() || *it != key)
+            return false;
+        keys.erase(it);
+        return true;
+    }
+
+    long long scan(int lo, int count) const
+    {
+        long long sum = 0;
+        for (auto it = lower_bound(keys.begin(), keys.end(), lo); it != keys.end() && count > 0; ++it, count--)
+            sum += *it;
+        return sum;
+    }
+
+    long bytes() const { return keys.capacity() * sizeof(int); }
+
+private:
+    vector<int> keys;
+};
+
+// ----------------------------------------------------------------------------
+// std::set: one heap node per key
+// ----------------------------------------------------------------------------
+
+class StdSet {
+public:
+    void bulkLoad(const vector<int> &sortedKeys)
+    {
+        for (int key : sortedKeys)
+            keys.insert(keys.end(), key);
+    }
+
+    bool contains(int key) const { return keys.count(key) != 0; }
+    bool insert(int key) { return keys.insert(key).second; }
+    bool erase(int key) { return keys.erase(key) != 0; }
+
+    long long scan(int lo, int count) const
+    {
+        long long sum = 0;
+        for (auto it = keys.lower_bound(lo); it != keys.end() && count > 0; ++it, count--)
+            sum += *it;
+        return sum;
+    }
+
+    // Red-black node: three pointers, the color and the key
+    long bytes() const { return keys.size() * (3 * sizeof(void *) + 2 * sizeof(int)); }
+
+private:
+    set<int> keys;
+};
+
+// ----------------------------------------------------------------------------
+// B+tree with every node exactly one cache line. Nodes live in two pools and
+// link by 32-bit index, which leaves room for 14 keys per leaf and 7 keys /
+// 8 children per inner node. Child i of an inner node holds the keys in
+// [keys[i - 1], keys[i]). Erase removes the key from its leaf and does not
+// merge underfull nodes, so separators stay valid without rebalancing.
+// ----------------------------------------------------------------------------
+
+struct alignas(64) BTreeLeaf {
+    int32_t count;
+    int32_t next;
+    int32_t keys[BTREE_LEAF_KEYS];
+};
+
+struct alignas(64) BTreeInner {
+    int32_t count;
+    int32_t keys[BTREE_INNER_KEYS];
+    int32_t children[BTREE_INNER_KEYS + 1];
+};
+
+class BPlusTree {
+public:
+    BPlusTree() : root(0), height(0)
+    {
+        leaves.push_back(BTreeLeaf());
+        leaves[0].count = 0;
+        leaves[0].next = -1;
+    }
+
+    void bulkLoad(const vector<int> &sortedKeys)
+    {
+        for (int key : sortedKeys)
+            insert(key);
+    }
+
+    bool contains(int key) const
+    {
+        const BTreeLeaf &leaf = leaves[findLeaf(key)];
+        for (int i = 0; i < leaf.count; i++)
+        {
+            if (leaf.keys[i] == key)
+                return true;
+        }
+        return false;
+    }
+
+    bool insert(int key)
+    {
+        int splitKey, splitNode;
+        bool inserted = insertInto(root, height, key, splitKey, splitNode);
+        if (splitNode >= 0)
+        {
+            BTreeInner node;
+            node.count = 1;
+            node.keys[0] = splitKey;
+            node.children[0] = root;
+            node.children[1] = splitNode;
+            inners.push_back(node);
+            root = inners.size() - 1;
+            height++;
+        }
+        return inserted;
+    }
+
+    bool erase(int key)
+    {
+        BTreeLeaf &leaf = leaves[findLeaf(key)];
+        for (int i = 0; i < leaf.count; i++)
+        {
+            if (leaf.keys[i] == key)
+            {
+                copy(leaf.keys + i + 1, leaf.keys + leaf.count, leaf.keys + i);
+                leaf.count--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    long long scan(int lo, int count) const
+    {
+        long long sum = 0;
+        int node = findLeaf(lo);
+        const BTreeLeaf *leaf = &leaves[node];
+        int i = lower_bound(leaf->keys, leaf->keys + leaf->count, lo) - leaf->keys;
+        while (count > 0)
+        {
+            if (i == leaf->count)
+            {
+                if (leaf->next < 0)
+                    break;
+                leaf = &leaves[leaf->next];
+                i = 0;
+                continue;
+            }
+            sum += leaf->keys[i++];
+            count--;
+        }
+        return sum;
+    }
+
+    long bytes() const { return leaves.size() * sizeof(BTreeLeaf) + inners.size() * sizeof(BTreeInner); }
+
+private:
+    vector<BTreeLeaf> leaves;
+    vector<BTreeInner> inners;
+    int root;
+    int height;     // inner levels above the leaves
+
+    static int childIndex(const BTreeInner &node, int key)
+    {
+        int i = 0;
+        while (i < node.count && key >= node.keys[i])
+            i++;
+        return i;
+    }
+
+    int findLeaf(int key) const
+    {
+        int node = root;
+        for (int level = height; level > 0; level--)
+            node = inners[node].children[childIndex(inners[node], key)];
+        return node;
+    }
+
+    // Inserts into the subtree of node. When node splits, splitKey is the
+    // first key of the new right sibling splitNode; splitNode is -1 otherwise.
+    bool insertInto(int node, int level, int key, int &splitKey, int &splitNode)
+    {
+        splitNode = -1;
+        if (level == 0)
+            return insertIntoLeaf(node, key, splitKey, splitNode);
+
+        int slot = childIndex(inners[node], key);
+        int childSplitKey, childSplitNode;
+        bool inserted = insertInto(inners[node].children[slot], level - 1, key, childSplitKey, childSplitNode);
+        if (childSplitNode < 0)
+            return inserted;
+
+        int keys[BTREE_INNER_KEYS + 1];
+        int children[BTREE_INNER_KEYS + 2];
+        BTreeInner &inner = inners[node];
+        int count = inner.count;
+        copy(inner.keys, inner.keys + slot, keys);
+        keys[slot] = childSplitKey;
+        copy(inner.keys + slot, inner.keys + count, keys + slot + 1);
+        copy(inner.children, inner.children + slot + 1, children);
+        children[slot + 1] = childSplitNode;
+        copy(inner.children + slot + 1, inner.children + count + 1, children + slot + 2);
+        count++;
+
+        if (count <= BTREE_INNER_KEYS)
+        {
+            inner.count = count;
+            copy(keys, keys + count, inner.keys);
+            copy(children, children + count + 1, inner.children);
+            return inserted;
+        }
+
+        // Split: the middle key moves up, the right half goes to a new node
+        int mid = count / 2;
+        BTreeInner right;
+        right.count = count - mid - 1;
+        copy(keys + mid + 1, keys + count, right.keys);
+        copy(children + mid + 1, children + count + 1, right.children);
+        inner.count = mid;
+        copy(keys, keys + mid, inner.keys);
+        copy(children, children + mid + 1, inner.children);
+
+        splitKey = keys[mid];
+        inners.push_back(right);
+        splitNode = inners.size() - 1;
+        return inserted;
+    }
+
+    bool insertIntoLeaf(int node, int key, int &splitKey, int &splitNode)
+    {
+        BTreeLeaf &leaf = leaves[node];
+        int pos = lower_bound(leaf.keys, leaf.keys + leaf.count, key) - leaf.keys;
+        if (pos < leaf.count && leaf.keys[pos] == key)
+            return false;
+
+        int keys[BTREE_LEAF_KEYS + 1];
+        int count = leaf.count;
+        copy(leaf.keys, leaf.keys + pos, keys);
+        keys[pos] = key;
+        copy(leaf.keys + pos, leaf.keys + count, keys + pos + 1);
+        count++;
+
+        if (count <= BTREE_LEAF_KEYS)
+        {
+            leaf.count = count;
+            copy(keys, keys + count, leaf.keys);
+            return true;
+        }
+
+        int mid = count / 2;
+        BTreeLeaf right;
+        right.count = count - mid;
+        right.next = leaf.next;
+        copy(keys + mid, keys + count, right.keys);
+        leaf.count = mid;
+        copy(keys, keys + mid, leaf.keys);
+
+        splitKey = right.keys[0];
+        splitNode = leaves.size();
+        leaf.next = splitNode;
+        // leaf is not used after this, push_back may move the pool
+        leaves.push_back(right);
+        return true;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Skiplist with p = 1/4. Every node is one allocation: the key, the level
+// and the forward pointers right behind them.
+// ----------------------------------------------------------------------------
+
+struct SkipNode {
+    int key;
+    int level;
+    SkipNode **next;
+};
+
+class SkipList {
+public:
+    SkipList() : rng(12345), level(1), allocatedBytes(0)
+    {
+        head = newNode(0, SKIPLIST_MAX_LEVEL);
+    }
+
+    ~SkipList()
+    {
+        SkipNode *node = head;
+        while (node != nullptr)
+        {
+            SkipNode *next = node->next[0];
+            ::operator delete(node);
+            node = next;
+        }
+    }
+
+    SkipList(const SkipList &) = delete;
+    SkipList &operator=(const SkipList &) = delete;
+
+    void bulkLoad(const vector<int> &sortedKeys)
+    {
+        for (int key : sortedKeys)
+            insert(key);
+    }
+
+    bool contains(int key) const
+    {
+        SkipNode *node = lowerBound(key);
+        return node != nullptr && node->key == key;
+    }
+
+    bool insert(int key)
+    {
+        SkipNode *update[SKIPLIST_MAX_LEVEL];
+        SkipNode *node = findPredecessors(key, update);
+        if (node != nullptr && node->key == key)
+            return false;
+
+        int nodeLevel = randomLevel();
+        for (int l = level; l < nodeLevel; l++)
+            update[l] = head;
+        level = max(level, nodeLevel);
+
+        SkipNode *inserted = newNode(key, nodeLevel);
+        for (int l = 0; l < nodeLevel; l++)
+        {
+            inserted->next[l] = update[l]->next[l];
+            update[l]->next[l] = inserted;
+        }
+        return true;
+    }
+
+    bool erase(int key)
+    {
+        SkipNode *update[SKIPLIST_MAX_LEVEL];
+        SkipNode *node = findPredecessors(key, update);
+        if (node == nullptr || node->key != key)
+            return false;
+        for (int l = 0; l < node->level; l++)
+            update[l]->next[l] = node->next[l];
+        allocatedBytes -= nodeBytes(node->level);
+        ::operator delete(node);
+        return true;
+    }
+
+    long long scan(int lo, int count) const
+    {
+        long long sum = 0;
+        for (SkipNode *node = lowerBound(lo); node != nullptr && count > 0; node = node->next[0], count--)
+            sum += node->key;
+        return sum;
+    }
+
+    long bytes() const { return allocatedBytes; }
+
+private:
+    SkipNode *head;
+    Xoshiro256 rng;
+    int level;
+    long allocatedBytes;
+
+    static size_t nodeBytes(int level) { return sizeof(SkipNode) + level * sizeof(SkipNode *); }
+
+    SkipNode *newNode(int key, int nodeLevel)
+    {
+        SkipNode *node = (SkipNode *) ::operator new(nodeBytes(nodeLevel));
+        node->key = key;
+        node->level = nodeLevel;
+        node->next = (SkipNode **) (node + 1);
+        fill(node->next, node->next + nodeLevel, nullptr);
+        allocatedBytes += nodeBytes(nodeLevel);
+        return node;
+    }
+
+    int randomLevel()
+    {
+        uint64_t bits = rng.next();
+        int l = 1;
+        while (l < SKIPLIST_MAX_LEVEL && (bits & 3) == 0)
+        {
+            l++;
+            bits >>= 2;
+        }
+        return l;
+    }
+
+    // First node with node->key >= key, update[l] the last node before it on level l
+    SkipNode *findPredecessors(int key, SkipNode **update) const
+    {
+        SkipNode *node = head;
+        for (int l = level - 1; l >= 0; l--)
+        {
+            while (node->next[l] != nullptr && node->next[l]->key < key)
+                node = node->next[l];
+            update[l] = node;
+        }
+        return node->next[0];
+    }
+
+    SkipNode *lowerBound(int key) const
+    {
+        SkipNode *update[SKIPLIST_MAX_LEVEL];
+        return findPredecessors(key, update);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Benchmark
+// ----------------------------------------------------------------------------
+
+// Keys are drawn from [0, 2 * size) and the containers start with the even
+// ones, so about half of every kind of operation hits and the size stays put
+static vector<ContainerOp> makeWorkload(int size, int operations)
+{
+    vector<ContainerOp> ops(operations);
+    Xoshiro256 rng(12345);
+    for (ContainerOp &op : ops)
+    {
+        int roll = rng.nextInRange(0, 99);
+        if (roll < INSERT_PERCENT)
+            op.kind = OP_INSERT;
+        else if (roll < INSERT_PERCENT + ERASE_PERCENT)
+            op.kind = OP_ERASE;
+        else if (roll < INSERT_PERCENT + ERASE_PERCENT + SCAN_PERCENT)
+            op.kind = OP_SCAN;
+        else
+            op.kind = OP_LOOKUP;
+        op.key = rng.nextInRange(0, 2LL * size - 1);
+    }
+    return ops;
+}
+
+template <typename Container>
+static long long replay(Container &container, const vector<ContainerOp> &ops)
+{
+    long long checksum = 0;
+    for (const ContainerOp &op : ops)
+    {
+        switch (op.kind)
+        {
+            case OP_INSERT: checksum += container.insert(op.key); break;
+            case OP_ERASE:  checksum += container.erase(op.key); break;
+            case OP_SCAN:   checksum += container.scan(op.key, RANGE_SCAN_LENGTH); break;
+            default:        checksum += container.contains(op.key); break;
+        }
+    }
+    return checksum;
+}
+
+static long long elapsedNs(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// Appends [container, bytes, build ns, replay ns, checksum]
+template <typename Container>
+static void benchmarkContainer(int id, const vector<int> &initial, const vector<ContainerOp> &ops,
+                               vector<jlong> &report)
+{
+    Container container;
+    auto start = chrono::high_resolution_clock::now();
+    container.bulkLoad(initial);
+    long long buildNs = elapsedNs(start);
+
+    start = chrono::high_resolution_clock::now();
+    long long checksum = replay(container, ops);
+    long long replayNs = elapsedNs(start);
+
+    report.push_back(id);
+    report.push_back(container.bytes());
+    report.push_back(buildNs);
+    report.push_back(replayNs);
+    report.push_back(checksum);
+}
+
+// Replays `operations` mixed operations against every container holding
+// `size` keys. Returns rows of [container, bytes after the replay, build ns,
+// replay ns, checksum]; the checksums must match across containers.
+// Updates on the sorted vector move size / 2 keys on average, keep
+// operations small when size is in the millions.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runOrderedContainerBenchmark(JNIEnv *env, jobject, jint size, jint operations)
+{
+    int n = max(1, (int) size);
+    vector<int> initial(n);
+    for (int i = 0; i < n; i++)
+        initial[i] = 2 * i;
+    vector<ContainerOp> ops = makeWorkload(n, max(0, (int) operations));
+
+    vector<jlong> report;
+    benchmarkContainer<SortedVectorSet>(CONTAINER_SORTED_VECTOR, initial, ops, report);
+    benchmarkContainer<StdSet>(CONTAINER_STD_SET, initial, ops, report);
+    benchmarkContainer<BPlusTree>(CONTAINER_BPLUS_TREE, initial, ops, report);
+    benchmarkContainer<SkipList>(CONTAINER_SKIPLIST, initial, ops, report);
+
+    const int ROW = 5;
+    for (int c = 1; c < CONTAINER_COUNT; c++)
+    {
+        if (report[c * ROW + 4] != report[4])
+            LOGE("Container %d checksum differs from the sorted vector", c);
+    }
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
@@ -0,0 +1,277 @@
+//
+// Multi-threaded sorts over every online core
+//
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+
+#include "../includes/sortingAlg.hpp"
+
+using namespace std;
+
+// Below this many elements per thread, spawning threads costs more than it saves
+static const int MIN_ELEMENTS_PER_THREAD = 4096;
+static const int SAMPLE_SORT_OVERSAMPLING = 32;
+// Bucket ids are stored in one byte per element
+static const int SAMPLE_SORT_MAX_BUCKETS = 256;
+
+int getOnlineCoreCount()
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int) cores : 1;
+}
+
+static int usableThreads(int n, int threadCount)
+{
+    int maxByWork = max(1, n / MIN_ELEMENTS_PER_THREAD);
+    return max(1, min(threadCount, maxByWork));
+}
+
+// Runs work(t) on threadCount threads and adds each thread's busy time to threadTimesMs[t]
+template <typename Work>
+static void runOnThreads(int threadCount, vector<double> &threadTimesMs, Work work)
+{
+    vector<thread> workers;
+    workers.reserve(threadCount);
+    for (int t = 0; t < threadCount; t++)
+    {
+        workers.emplace_back([t, &threadTimesMs, &work]() {
+            auto start = chrono::high_resolution_clock::now();
+            work(t);
+            auto end = chrono::high_resolution_clock::now();
+            threadTimesMs[t] += chrono::duration<double, milli>(end - start).count();
+        });
+    }
+    for (thread &worker : workers)
+        worker.join();
+}
+
+template <typename Metrics>
+static void mergeThreadMetrics(const vector<Metrics> &threadMetrics, Metrics &metrics)
+{
+    for (const Metrics &m : threadMetrics)
+    {
+        metrics.comparison += m.comparison;
+        metrics.assigments += m.assigments;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Sample sort: pick threadCount - 1 splitters from a random sample, let every
+// thread classify its slice of the input into buckets, scatter the buckets to
+// their final ranges and sort each bucket on its own thread.
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+void parallelSampleSort(IntSpan array, int threadCount, Metrics &metrics, vector<double> &threadTimesMs)
+{
+    int n = array.size();
+    int p = min(usableThreads(n, threadCount), SAMPLE_SORT_MAX_BUCKETS);
+    threadTimesMs.assign(p, 0.0);
+    if (p == 1)
+    {
+        runOnThreads(1, threadTimesMs, [&](int) { pdqSort(array, metrics); });
+        return;
+    }
+
+    // Splitters
+    mt19937 gen(12345);
+    uniform_int_distribution<int> pick(0, n - 1);
+    vector<int> sample(p * SAMPLE_SORT_OVERSAMPLING);
+    for (int &s : sample)
+        s = array[pick(gen)];
+    pdqSort(sample, metrics);
+    vector<int> splitters(p - 1);
+    for (int b = 1; b < p; b++)
+        splitters[b - 1] = sample[b * SAMPLE_SORT_OVERSAMPLING];
+
+    vector<Metrics> threadMetrics(p);
+    vector<vector<int>> bucketCounts(p, vector<int>(p, 0));
+    vector<unsigned char> bucketOf(n);
+
+    // 1. Classify
+    runOnThreads(p, threadTimesMs, [&](int t) {
+        Metrics &m = threadMetrics[t];
+        int lo = (long long) n * t / p;
+        int hi = (long long) n * (t + 1) / p;
+        for (int i = lo; i < hi; i++)
+        {
+            // Upper bound over the splitters, so keys equal to a splitter go right
+            int left = 0;
+            int right = p - 1;
+            while (left < right)
+            {
+                int mid = (left + right) / 2;
+                if (lessThan(array[i], splitters[mid], m))
+                    right = mid;
+                else
+                    left = mid + 1;
+            }
+            bucketOf[i] = (unsigned char) left;
+            bucketCounts[t][left]++;
+        }
+    });
+
+    // Slice t writes its part of bucket b from offsets[t][b]
+    vector<vector<int>> offsets(p, vector<int>(p));
+    vector<vector<int>> buckets(p);
+    vector<int> bucketStart(p, 0);
+    int running = 0;
+    for (int b = 0; b < p; b++)
+    {
+        bucketStart[b] = running;
+        int bucketSize = 0;
+        for (int t = 0; t < p; t++)
+        {
+            offsets[t][b] = bucketSize;
+            bucketSize += bucketCounts[t][b];
+        }
+        buckets[b].resize(bucketSize);
+        running += bucketSize;
+    }
+
+    // 2. Scatter
+    runOnThreads(p, threadTimesMs, [&](int t) {
+        int lo = (long long) n * t / p;
+        int hi = (long long) n * (t + 1) / p;
+        vector<int> &next = offsets[t];
+        for (int i = lo; i < hi; i++)
+        {
+            int b = bucketOf[i];
+            buckets[b][next[b]++] = array[i];
+        }
+        threadMetrics[t].assigments += hi - lo;
+    });
+
+    // 3. Sort every bucket on its own thread and copy it to its final range
+    runOnThreads(p, threadTimesMs, [&](int t) {
+        vector<int> &bucket = buckets[t];
+        pdqSort(bucket, threadMetrics[t]);
+        copy(bucket.begin(), bucket.end(), array.begin() + bucketStart[t]);
+        threadMetrics[t].assigments += bucket.size();
+    });
+
+    mergeThreadMetrics(threadMetrics, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// Merge sort with merge-path partitioning: every thread sorts one slice, then
+// each round merges pairs of runs. Instead of one thread per merge, thread t
+// always produces output slice t, and finds where that slice starts in both
+// input runs with a binary search along the merge path, so all threads stay
+// busy until the last round.
+// ----------------------------------------------------------------------------
+
+// Number of elements taken from a in the first diag outputs of a stable merge of a and b
+template <typename Metrics>
+static int mergePathSplit(const int *a, int lengthA, const int *b, int lengthB, int diag, Metrics &metrics)
+{
+    int lo = max(0, diag - lengthB);
+    int hi = min(diag, lengthA);
+    while (lo < hi)
+    {
+        int i = (lo + hi) / 2;
+        if (lessThan(b[diag - i - 1], a[i], metrics))
+            hi = i;
+        else
+            lo = i + 1;
+    }
+    return lo;
+}
+
+template <typename Metrics>
+void parallelMergeSort(IntSpan array, int threadCount, Metrics &metrics, vector<double> &threadTimesMs)
+{
+    int n = array.size();
+    int p = usableThreads(n, threadCount);
+    threadTimesMs.assign(p, 0.0);
+    if (p == 1)
+    {
+        runOnThreads(1, threadTimesMs, [&](int) { pdqSort(array, metrics); });
+        return;
+    }
+
+    vector<int> bounds(p + 1);
+    for (int t = 0; t <= p; t++)
+        bounds[t] = (long long) n * t / p;
+
+    vector<Metrics> threadMetrics(p);
+
+    runOnThreads(p, threadTimesMs, [&](int t) {
+        pdqSort(IntSpan(array.data() + bounds[t], bounds[t + 1] - bounds[t]), threadMetrics[t]);
+    });
+
+    vector<int> scratch(n);
+    int *src = array.data();
+    int *dst = scratch.data();
+    for (int width = 1; width < p; width *= 2)
+    {
+        runOnThreads(p, threadTimesMs, [&](int t) {
+            Metrics &m = threadMetrics[t];
+            int groupStart = t / (2 * width) * (2 * width);
+            int groupMid = min(groupStart + width, p);
+            int groupEnd = min(groupStart + 2 * width, p);
+
+            const int *a = src + bounds[groupStart];
+            const int *b = src + bounds[groupMid];
+            int lengthA = bounds[groupMid] - bounds[groupStart];
+            int lengthB = bounds[groupEnd] - bounds[groupMid];
+
+            int diagStart = bounds[t] - bounds[groupStart];
+            int diagEnd = bounds[t + 1] - bounds[groupStart];
+            int i = mergePathSplit(a, lengthA, b, lengthB, diagStart, m);
+            int j = diagStart - i;
+            int iEnd = mergePathSplit(a, lengthA, b, lengthB, diagEnd, m);
+            int jEnd = diagEnd - iEnd;
+
+            int *out = dst + bounds[t];
+            while (i < iEnd && j < jEnd)
+            {
+                if (lessThan(b[j], a[i], m))
+                    *out++ = b[j++];
+                else
+                    *out++ = a[i++];
+            }
+            while (i < iEnd)
+                *out++ = a[i++];
+            while (j < jEnd)
+                *out++ = b[j++];
+            m.assigments += diagEnd - diagStart;
+        });
+        swap(src, dst);
+    }
+
+    if (src != array.data())
+    {
+        copy(src, src + n, array.data());
+        metrics.assigments += n;
+    }
+
+    mergeThreadMetrics(threadMetrics, metrics);
+}
+
+// Registry entries: every online core, per-thread times dropped
+
+template <typename Metrics>
+void parallelSampleSortAllCores(IntSpan array, Metrics &metrics)
+{
+    vector<double> threadTimesMs;
+    parallelSampleSort(array, getOnlineCoreCount(), metrics, threadTimesMs);
+}
+
+template <typename Metrics>
+void parallelMergeSortAllCores(IntSpan array, Metrics &metrics)
+{
+    vector<double> threadTimesMs;
+    parallelMergeSort(array, getOnlineCoreCount(), metrics, threadTimesMs);
+}
+
+template void parallelSampleSort<SortMetrics>(IntSpan, int, SortMetrics&, vector<double>&);
+template void parallelSampleSort<NoMetrics>(IntSpan, int, NoMetrics&, vector<double>&);
+template void parallelMergeSort<SortMetrics>(IntSpan, int, SortMetrics&, vector<double>&);
+template void parallelMergeSort<NoMetrics>(IntSpan, int, NoMetrics&, vector<double>&);
+INSTANTIATE_SORT_KERNEL(parallelSampleSortAllCores)
+INSTANTIATE_SORT_KERNEL(parallelMergeSortAllCores)
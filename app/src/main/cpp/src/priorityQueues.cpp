@@ -0,0 +1,442 @@
+//
+// Priority queues under Dijkstra: push, decrease-key and pop in the order a
+// shortest-path search on a random graph issues them. The binary and 4-ary
+// heaps are maxHeapify's sift with the order flipped plus a position index
+// for decrease-key; the pairing heap cuts and re-melds on decrease-key; the
+// radix heap relies on the keys being monotone and handles decrease-key as a
+// second push, skipping the stale entry when it is popped.
+//
+#include <jni.h>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/dataGenerator.hpp"
+
+#define LOG_TAG "PriorityQueues"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const int GRAPH_DEGREE = 8;
+static const uint32_t MAX_EDGE_WEIGHT = 1000;
+static const uint32_t UNREACHED = numeric_limits<uint32_t>::max();
+
+// Ids are shared with Kotlin, append only
+enum PriorityQueueKind {
+    QUEUE_BINARY_HEAP = 0,
+    QUEUE_4ARY_HEAP,
+    QUEUE_PAIRING_HEAP,
+    QUEUE_RADIX_HEAP,
+    QUEUE_KIND_COUNT
+};
+
+struct QueueEntry {
+    uint32_t key;
+    int vertex;
+};
+
+// ----------------------------------------------------------------------------
+// Indexed d-ary min-heap. position[v] is the slot of vertex v, -1 when it is
+// not queued, and moves along with every swap of the sift.
+// ----------------------------------------------------------------------------
+
+template <int D>
+class IndexedDaryHeap {
+public:
+    explicit IndexedDaryHeap(int vertexCount) : position(vertexCount, -1) {}
+
+    bool empty() const { return heap.empty(); }
+
+    void push(int vertex, uint32_t key)
+    {
+        heap.push_back({key, vertex});
+        position[vertex] = heap.size() - 1;
+        siftUp(heap.size() - 1);
+    }
+
+    void decreaseKey(int vertex, uint32_t key)
+    {
+        int i = position[vertex];
+        heap[i].key = key;
+        siftUp(i);
+    }
+
+    QueueEntry pop()
+    {
+        QueueEntry top = heap[0];
+        position[top.vertex] = -1;
+        heap[0] = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            position[heap[0].vertex] = 0;
+            siftDown(0);
+        }
+        return top;
+    }
+
+    long bytes() const { return heap.capacity() * sizeof(QueueEntry) + position.size() * sizeof(int); }
+
+private:
+    vector<QueueEntry> heap;
+    vector<int> position;
+
+    void place(int i, const QueueEntry &entry)
+    {
+        heap[i] = entry;
+        position[entry.vertex] = i;
+    }
+
+    void siftUp(int i)
+    {
+        QueueEntry entry = heap[i];
+        while (i > 0)
+        {
+            int parent = (i - 1) / D;
+            if (heap[parent].key <= entry.key)
+                break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+
+    // maxHeapify's loop for a min-heap: find the smallest of the children,
+    // move it up while it beats the entry being sifted
+    void siftDown(int i)
+    {
+        int n = heap.size();
+        QueueEntry entry = heap[i];
+        while (true)
+        {
+            int first = D * i + 1;
+            if (first >= n)
+                break;
+            int smallest = first;
+            int last = min(first + D, n);
+            for (int c = first + 1; c < last; c++)
+            {
+                if (heap[c].key < heap[smallest].key)
+                    smallest = c;
+            }
+            if (heap[smallest].key >= entry.key)
+                break;
+            place(i, heap[smallest]);
+            i = smallest;
+        }
+        place(i, entry);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Pairing heap, one preallocated node per vertex. prev is the previous
+// sibling, or the parent for a first child.
+// ----------------------------------------------------------------------------
+
+class PairingHeap {
+public:
+    explicit PairingHeap(int vertexCount) : nodes(vertexCount), root(-1) {}
+
+    bool empty() const { return root < 0; }
+
+    void push(int vertex, uint32_t key)
+    {
+        nodes[vertex] = {key, -1, -1, -1};
+        root = meld(root, vertex);
+    }
+
+    void decreaseKey(int vertex, uint32_t key)
+    {
+        nodes[vertex].key = key;
+        if (vertex == root)
+            return;
+        cut(vertex);
+        root = meld(root, vertex);
+    }
+
+    QueueEntry pop()
+    {
+        int top = root;
+        root = mergePairs(nodes[top].child);
+        return {nodes[top].key, top};
+    }
+
+    long bytes() const { return nodes.capacity() * sizeof(PairingNode) + pairs.capacity() * sizeof(int); }
+
+private:
+    struct PairingNode {
+        uint32_t key;
+        int child;
+        int next;
+        int prev;
+    };
+
+    vector<PairingNode> nodes;
+    vector<int> pairs;
+    int root;
+
+    // Both arguments are detached roots
+    int meld(int a, int b)
+    {
+        if (a < 0)
+            return b;
+        if (b < 0)
+            return a;
+        if (nodes[b].key < nodes[a].key)
+            swap(a, b);
+        nodes[b].next = nodes[a].child;
+        if (nodes[a].child >= 0)
+            nodes[nodes[a].child].prev = b;
+        nodes[b].prev = a;
+        nodes[a].child = b;
+        return a;
+    }
+
+    void cut(int v)
+    {
+        int p = nodes[v].prev;
+        if (nodes[p].child == v)
+            nodes[p].child = nodes[v].next;
+        else
+            nodes[p].next = nodes[v].next;
+        if (nodes[v].next >= 0)
+            nodes[nodes[v].next].prev = p;
+        nodes[v].next = -1;
+        nodes[v].prev = -1;
+    }
+
+    // Two-pass merge: meld neighbours left to right, then fold right to left
+    int mergePairs(int first)
+    {
+        pairs.clear();
+        while (first >= 0)
+        {
+            int a = first;
+            int b = nodes[a].next;
+            first = b >= 0 ? nodes[b].next : -1;
+            nodes[a].next = nodes[a].prev = -1;
+            if (b >= 0)
+                nodes[b].next = nodes[b].prev = -1;
+            pairs.push_back(meld(a, b));
+        }
+        int result = -1;
+        for (int i = (int) pairs.size() - 1; i >= 0; i--)
+            result = meld(pairs[i], result);
+        return result;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Radix heap (Ahuja, Mehlhorn, Orlin, Tarjan): bucket i holds the keys whose
+// highest bit differing from the last popped key is bit i - 1. A pop that
+// finds bucket 0 empty redistributes the first non-empty bucket around its
+// minimum, and every key only moves to lower buckets.
+// ----------------------------------------------------------------------------
+
+class RadixHeap {
+public:
+    explicit RadixHeap(int) : last(0), count(0) {}
+
+    bool empty() const { return count == 0; }
+
+    void push(int vertex, uint32_t key)
+    {
+        buckets[bucketOf(key)].push_back({key, vertex});
+        count++;
+    }
+
+    // Lazy: the old entry stays and is skipped by the caller when popped
+    void decreaseKey(int vertex, uint32_t key)
+    {
+        push(vertex, key);
+    }
+
+    QueueEntry pop()
+    {
+        if (buckets[0].empty())
+        {
+            int i = 1;
+            while (buckets[i].empty())
+                i++;
+            uint32_t minimum = UNREACHED;
+            for (const QueueEntry &e : buckets[i])
+                minimum = min(minimum, e.key);
+            last = minimum;
+            for (const QueueEntry &e : buckets[i])
+                buckets[bucketOf(e.key)].push_back(e);
+            buckets[i].clear();
+        }
+        QueueEntry top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+
+    long bytes() const
+    {
+        long total = 0;
+        for (const vector<QueueEntry> &bucket : buckets)
+            total += bucket.capacity() * sizeof(QueueEntry);
+        return total;
+    }
+
+private:
+    vector<QueueEntry> buckets[33];
+    uint32_t last;
+    long count;
+
+    int bucketOf(uint32_t key) const
+    {
+        return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Dijkstra driver
+// ----------------------------------------------------------------------------
+
+// Compressed adjacency: edges of v are targets/weights[offsets[v], offsets[v + 1])
+struct Graph {
+    vector<int> offsets;
+    vector<int> targets;
+    vector<uint32_t> weights;
+
+    long bytes() const
+    {
+        return offsets.size() * sizeof(int) + targets.size() * sizeof(int) + weights.size() * sizeof(uint32_t);
+    }
+};
+
+// GRAPH_DEGREE random out-edges per vertex plus v -> v + 1, so every vertex
+// is reachable from 0
+static Graph makeGraph(int vertexCount)
+{
+    Graph g;
+    Xoshiro256 rng(12345);
+    g.offsets.reserve(vertexCount + 1);
+    for (int v = 0; v < vertexCount; v++)
+    {
+        g.offsets.push_back(g.targets.size());
+        if (v + 1 < vertexCount)
+        {
+            g.targets.push_back(v + 1);
+            g.weights.push_back(rng.nextInRange(1, MAX_EDGE_WEIGHT));
+        }
+        for (int e = 0; e < GRAPH_DEGREE; e++)
+        {
+            g.targets.push_back(rng.nextInRange(0, vertexCount - 1));
+            g.weights.push_back(rng.nextInRange(1, MAX_EDGE_WEIGHT));
+        }
+    }
+    g.offsets.push_back(g.targets.size());
+    return g;
+}
+
+struct QueueCounts {
+    long pushes = 0;
+    long decreaseKeys = 0;
+    long pops = 0;
+    long peakBytes = 0;
+    uint64_t distanceSum = 0;
+};
+
+template <typename Queue>
+static QueueCounts runDijkstra(const Graph &g, int vertexCount)
+{
+    QueueCounts counts;
+    Queue queue(vertexCount);
+    vector<uint32_t> dist(vertexCount, UNREACHED);
+
+    dist[0] = 0;
+    queue.push(0, 0);
+    counts.pushes++;
+    while (!queue.empty())
+    {
+        QueueEntry top = queue.pop();
+        counts.pops++;
+        // Stale entry left behind by a lazy decrease-key
+        if (top.key > dist[top.vertex])
+            continue;
+
+        for (int e = g.offsets[top.vertex]; e < g.offsets[top.vertex + 1]; e++)
+        {
+            int u = g.targets[e];
+            uint32_t candidate = top.key + g.weights[e];
+            if (candidate >= dist[u])
+                continue;
+            if (dist[u] == UNREACHED)
+            {
+                queue.push(u, candidate);
+                counts.pushes++;
+            }
+            else
+            {
+                queue.decreaseKey(u, candidate);
+                counts.decreaseKeys++;
+            }
+            dist[u] = candidate;
+        }
+    }
+    // Capacities only grow, so this is the peak
+    counts.peakBytes = queue.bytes();
+
+    for (uint32_t d : dist)
+        counts.distanceSum += d;
+    return counts;
+}
+
+// Appends [queue, ns, pushes, decrease-keys, pops, ops per second, queue bytes, distance sum]
+template <typename Queue>
+static void benchmarkQueue(int id, const Graph &g, int vertexCount, vector<jlong> &report)
+{
+    auto start = chrono::high_resolution_clock::now();
+    QueueCounts counts = runDijkstra<Queue>(g, vertexCount);
+    auto end = chrono::high_resolution_clock::now();
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    long operations = counts.pushes + counts.decreaseKeys + counts.pops;
+
+    report.push_back(id);
+    report.push_back(ns);
+    report.push_back(counts.pushes);
+    report.push_back(counts.decreaseKeys);
+    report.push_back(counts.pops);
+    report.push_back(ns > 0 ? (jlong) (operations * 1e9 / ns) : 0);
+    report.push_back(counts.peakBytes);
+    report.push_back(counts.distanceSum);
+}
+
+// Dijkstra from vertex 0 of a random graph with vertexCount vertices and
+// degree 9 with every queue. Returns [vertices, edges, graph bytes], then
+// rows of [queue, ns, pushes, decrease-keys, pops, ops per second, peak
+// queue bytes, distance sum]; the distance sums must match. The graph takes
+// about 76 bytes per vertex (offset, 9 targets, 9 weights), so ~400 vertices
+// fit a 32 KB L1 and 1e6 are DRAM-resident.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runPriorityQueueBenchmark(JNIEnv *env, jobject, jint vertexCount)
+{
+    int n = max(1, (int) vertexCount);
+    Graph g = makeGraph(n);
+
+    vector<jlong> report;
+    report.push_back(n);
+    report.push_back(g.targets.size());
+    report.push_back(g.bytes());
+    benchmarkQueue<IndexedDaryHeap<2>>(QUEUE_BINARY_HEAP, g, n, report);
+    benchmarkQueue<IndexedDaryHeap<4>>(QUEUE_4ARY_HEAP, g, n, report);
+    benchmarkQueue<PairingHeap>(QUEUE_PAIRING_HEAP, g, n, report);
+    benchmarkQueue<RadixHeap>(QUEUE_RADIX_HEAP, g, n, report);
+
+    const int HEADER = 3, ROW = 8;
+    for (int q = 1; q < QUEUE_KIND_COUNT; q++)
+    {
+        if (report[HEADER + q * ROW + 7] != report[HEADER + 7])
+            LOGE("Queue %d found different distances than the binary heap", q);
+    }
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
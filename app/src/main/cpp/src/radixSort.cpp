@@ -0,0 +1,266 @@
+//
+// Radix sorts for integer keys. Signed keys are sorted as unsigned with the
+// sign bit flipped, so negative values still come first.
+//
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "../includes/sortingAlg.hpp"
+#include "../includes/elementTraits.hpp"
+
+using namespace std;
+
+static const uint32_t SIGN_BIT_32 = 0x80000000u;
+static const uint64_t SIGN_BIT_64 = 0x8000000000000000ull;
+static const int MSD_INSERTION_THRESHOLD = 64;
+
+// ----------------------------------------------------------------------------
+// LSD radix sort on 32-bit keys. One read of the input builds the histograms
+// of every digit at once; a digit whose histogram has a single non-empty
+// bucket cannot reorder anything and its pass is skipped. With the default
+// input in [1, 1e6] that drops the top byte (8-bit digits) or the top 10 bits
+// (11-bit digits) without any special casing.
+// ----------------------------------------------------------------------------
+
+// Ping-pong buffers, kept between calls on the same thread
+static thread_local vector<int> lsdScratch;
+static thread_local vector<int64_t> msdScratch;
+
+void releaseRadixScratch()
+{
+    vector<int>().swap(lsdScratch);
+    vector<int64_t>().swap(msdScratch);
+}
+
+template <int DIGIT_BITS, typename Metrics>
+static void lsdRadixSort32(IntSpan array, Metrics &metrics)
+{
+    const int RADIX = 1 << DIGIT_BITS;
+    const int DIGITS = (32 + DIGIT_BITS - 1) / DIGIT_BITS;
+    const uint32_t MASK = RADIX - 1;
+
+    int n = array.size();
+    if (n < 2)
+        return;
+
+    // Fused histogram pass
+    vector<vector<int>> counts(DIGITS, vector<int>(RADIX, 0));
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t key = (uint32_t) array[i] ^ SIGN_BIT_32;
+        for (int d = 0; d < DIGITS; d++)
+            counts[d][(key >> (d * DIGIT_BITS)) & MASK]++;
+    }
+
+    lsdScratch.resize(n);
+    int *src = array.data();
+    int *dst = lsdScratch.data();
+
+    for (int d = 0; d < DIGITS; d++)
+    {
+        vector<int> &count = counts[d];
+        int shift = d * DIGIT_BITS;
+
+        // Trivial digit: every key has the same value here
+        uint32_t firstDigit = (((uint32_t) src[0] ^ SIGN_BIT_32) >> shift) & MASK;
+        if (count[firstDigit] == n)
+            continue;
+
+        int offset = 0;
+        for (int b = 0; b < RADIX; b++)
+        {
+            int c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t key = (uint32_t) src[i] ^ SIGN_BIT_32;
+            dst[count[(key >> shift) & MASK]++] = src[i];
+        }
+        metrics.assigments += n;
+        swap(src, dst);
+    }
+
+    if (src != array.data())
+    {
+        copy(src, src + n, array.data());
+        metrics.assigments += n;
+    }
+}
+
+template <typename Metrics>
+void lsdRadixSort8(IntSpan array, Metrics &metrics)
+{
+    lsdRadixSort32<8>(array, metrics);
+}
+
+template <typename Metrics>
+void lsdRadixSort11(IntSpan array, Metrics &metrics)
+{
+    lsdRadixSort32<11>(array, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// MSD radix sort on 64-bit keys, 8 bits per level. Buckets smaller than
+// MSD_INSERTION_THRESHOLD are finished with insertion sort, and a level where
+// all keys share the same byte is skipped without moving anything.
+// ----------------------------------------------------------------------------
+
+static inline uint64_t msdKey(int64_t value)
+{
+    return (uint64_t) value ^ SIGN_BIT_64;
+}
+
+template <typename Metrics>
+static void msdInsertionSort(int64_t *keys, int n, Metrics &metrics)
+{
+    for (int i = 1; i < n; i++)
+    {
+        int64_t key = keys[i];
+        int j = i - 1;
+        while (j >= 0)
+        {
+            metrics.comparison++;
+            if (keys[j] <= key)
+                break;
+            keys[j + 1] = keys[j];
+            metrics.assigments++;
+            j--;
+        }
+        keys[j + 1] = key;
+        metrics.assigments += 2;
+    }
+}
+
+template <typename Metrics>
+static void msdRadixSortLevel(int64_t *keys, int64_t *buffer, int n, int shift, Metrics &metrics)
+{
+    while (true)
+    {
+        if (n < MSD_INSERTION_THRESHOLD)
+        {
+            msdInsertionSort(keys, n, metrics);
+            return;
+        }
+
+        int count[256] = {0};
+        for (int i = 0; i < n; i++)
+            count[(msdKey(keys[i]) >> shift) & 0xFF]++;
+
+        int firstDigit = (msdKey(keys[0]) >> shift) & 0xFF;
+        if (count[firstDigit] == n)
+        {
+            if (shift == 0)
+                return;
+            shift -= 8;
+            continue;
+        }
+
+        int start[257];
+        start[0] = 0;
+        for (int b = 0; b < 256; b++)
+            start[b + 1] = start[b] + count[b];
+
+        int next[256];
+        copy(start, start + 256, next);
+        for (int i = 0; i < n; i++)
+            buffer[next[(msdKey(keys[i]) >> shift) & 0xFF]++] = keys[i];
+        copy(buffer, buffer + n, keys);
+        metrics.assigments += 2 * n;
+
+        if (shift == 0)
+            return;
+        for (int b = 0; b < 256; b++)
+        {
+            if (count[b] > 1)
+                msdRadixSortLevel(keys + start[b], buffer + start[b], count[b], shift - 8, metrics);
+        }
+        return;
+    }
+}
+
+template <typename Metrics>
+void msdRadixSort64(vector<int64_t> &keys, Metrics &metrics)
+{
+    int n = keys.size();
+    if (n < 2)
+        return;
+    msdScratch.resize(n);
+    msdRadixSortLevel(keys.data(), msdScratch.data(), n, 56, metrics);
+}
+
+// Registry adapter: widens the ints to 64-bit keys, so the upper levels are
+// all trivial and the cost of skipping them shows up in the timing
+template <typename Metrics>
+void msdRadixSortHybrid(IntSpan array, Metrics &metrics)
+{
+    vector<int64_t> keys(array.begin(), array.end());
+    msdRadixSort64(keys, metrics);
+    copy(keys.begin(), keys.end(), array.begin());
+    metrics.assigments += 2 * array.size();
+}
+
+// ----------------------------------------------------------------------------
+// LSD radix sort on any element type. The digits come from
+// ElementTraits<T>::radixByte, so the sign flip of integers, the bit flip of
+// floats and the key-then-payload order of pairs are inlined into the passes,
+// and the number of passes is the key width of the type. Trivial digits are
+// skipped like in lsdRadixSort32.
+// ----------------------------------------------------------------------------
+
+template <typename T, typename Metrics>
+void lsdRadixSortElements(Span<T> array, Metrics &metrics)
+{
+    typedef ElementTraits<T> Traits;
+    int n = array.size();
+    if (n < 2)
+        return;
+
+    vector<vector<int>> counts(Traits::KEY_BYTES, vector<int>(256, 0));
+    for (int i = 0; i < n; i++)
+    {
+        for (int d = 0; d < Traits::KEY_BYTES; d++)
+            counts[d][Traits::radixByte(array[i], d)]++;
+    }
+
+    static thread_local vector<T> buffer;
+    buffer.resize(n);
+    T *src = array.data();
+    T *dst = buffer.data();
+
+    for (int d = 0; d < Traits::KEY_BYTES; d++)
+    {
+        vector<int> &count = counts[d];
+        if (count[Traits::radixByte(src[0], d)] == n)
+            continue;
+
+        int offset = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            int c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+
+        for (int i = 0; i < n; i++)
+            dst[count[Traits::radixByte(src[i], d)]++] = src[i];
+        metrics.assigments += n;
+        swap(src, dst);
+    }
+
+    if (src != array.data())
+    {
+        copy(src, src + n, array.data());
+        metrics.assigments += n;
+    }
+}
+
+template void msdRadixSort64<SortMetrics>(vector<int64_t>&, SortMetrics&);
+template void msdRadixSort64<NoMetrics>(vector<int64_t>&, NoMetrics&);
+INSTANTIATE_SORT_KERNEL(lsdRadixSort8)
+INSTANTIATE_SORT_KERNEL(lsdRadixSort11)
+INSTANTIATE_SORT_KERNEL(msdRadixSortHybrid)
+INSTANTIATE_ELEMENT_KERNEL(lsdRadixSortElements)
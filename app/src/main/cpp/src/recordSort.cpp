@@ -0,0 +1,199 @@
+//
+// Sorting records instead of bare ints: 16, 32 and 64 byte records keyed by
+// a 32 or 64 bit key, in three layouts. All layouts use the same std::sort,
+// so the differences come from how many bytes every move drags along and
+// how the payload is brought into order afterwards.
+//
+#include <jni.h>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/dataGenerator.hpp"
+
+#define LOG_TAG "RecordSort"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+enum RecordLayout {
+    LAYOUT_AOS = 0,          // array of structs, whole records are moved
+    LAYOUT_SOA = 1,          // keys and payloads apart, sort a permutation, then gather both
+    LAYOUT_KEY_INDEX = 2,    // sort (key, index) pairs, then gather the records
+};
+
+template <typename Key, int BYTES>
+struct Record {
+    Key key;
+    unsigned char payload[BYTES - sizeof(Key)];
+};
+
+template <typename Key>
+struct KeyIndex {
+    Key key;
+    uint32_t index;
+};
+
+struct RecordSortTiming {
+    long long sortNs = 0;
+    long long gatherNs = 0;
+};
+
+// The payload repeats the low byte of the key, so a gather that mixes
+// records up is caught by the check
+template <typename Key, int BYTES>
+static vector<Record<Key, BYTES>> makeRecords(int count)
+{
+    vector<Record<Key, BYTES>> records(count);
+    Xoshiro256 rng(12345);
+    for (Record<Key, BYTES> &r : records)
+    {
+        r.key = (Key) rng.next();
+        memset(r.payload, (unsigned char) r.key, sizeof(r.payload));
+    }
+    return records;
+}
+
+template <typename Key, int BYTES>
+static bool checkRecords(const Key *keys, const unsigned char *payloads, size_t keyStride, size_t payloadStride, int count)
+{
+    const size_t payloadBytes = BYTES - sizeof(Key);
+    for (int i = 0; i < count; i++)
+    {
+        Key key = *(const Key *) ((const unsigned char *) keys + i * keyStride);
+        if (i > 0 && key < *(const Key *) ((const unsigned char *) keys + (i - 1) * keyStride))
+            return false;
+        const unsigned char *payload = payloads + i * payloadStride;
+        if (payload[0] != (unsigned char) key || payload[payloadBytes - 1] != (unsigned char) key)
+            return false;
+    }
+    return true;
+}
+
+static long long elapsedNs(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count();
+}
+
+template <typename Key, int BYTES>
+static RecordSortTiming sortArrayOfStructs(const vector<Record<Key, BYTES>> &input, bool &ok)
+{
+    typedef Record<Key, BYTES> R;
+    RecordSortTiming timing;
+    vector<R> records = input;
+
+    auto start = chrono::high_resolution_clock::now();
+    sort(records.begin(), records.end(), [](const R &a, const R &b) { return a.key < b.key; });
+    timing.sortNs = elapsedNs(start);
+
+    ok = checkRecords<Key, BYTES>(&records[0].key, records[0].payload, sizeof(R), sizeof(R), records.size());
+    return timing;
+}
+
+template <typename Key, int BYTES>
+static RecordSortTiming sortStructOfArrays(const vector<Record<Key, BYTES>> &input, bool &ok)
+{
+    const size_t payloadBytes = BYTES - sizeof(Key);
+    int n = input.size();
+    RecordSortTiming timing;
+
+    vector<Key> keys(n);
+    vector<unsigned char> payloads(n * payloadBytes);
+    for (int i = 0; i < n; i++)
+    {
+        keys[i] = input[i].key;
+        memcpy(&payloads[i * payloadBytes], input[i].payload, payloadBytes);
+    }
+
+    // Every comparison loads its keys through the permutation
+    auto start = chrono::high_resolution_clock::now();
+    vector<uint32_t> permutation(n);
+    iota(permutation.begin(), permutation.end(), 0);
+    sort(permutation.begin(), permutation.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+    timing.sortNs = elapsedNs(start);
+
+    start = chrono::high_resolution_clock::now();
+    vector<Key> sortedKeys(n);
+    vector<unsigned char> sortedPayloads(n * payloadBytes);
+    for (int i = 0; i < n; i++)
+    {
+        sortedKeys[i] = keys[permutation[i]];
+        memcpy(&sortedPayloads[i * payloadBytes], &payloads[permutation[i] * payloadBytes], payloadBytes);
+    }
+    timing.gatherNs = elapsedNs(start);
+
+    ok = checkRecords<Key, BYTES>(sortedKeys.data(), sortedPayloads.data(), sizeof(Key), payloadBytes, n);
+    return timing;
+}
+
+template <typename Key, int BYTES>
+static RecordSortTiming sortKeyIndexPairs(const vector<Record<Key, BYTES>> &input, bool &ok)
+{
+    typedef Record<Key, BYTES> R;
+    int n = input.size();
+    RecordSortTiming timing;
+
+    auto start = chrono::high_resolution_clock::now();
+    vector<KeyIndex<Key>> pairs(n);
+    for (int i = 0; i < n; i++)
+        pairs[i] = {input[i].key, (uint32_t) i};
+    sort(pairs.begin(), pairs.end(), [](const KeyIndex<Key> &a, const KeyIndex<Key> &b) { return a.key < b.key; });
+    timing.sortNs = elapsedNs(start);
+
+    start = chrono::high_resolution_clock::now();
+    vector<R> records(n);
+    for (int i = 0; i < n; i++)
+        records[i] = input[pairs[i].index];
+    timing.gatherNs = elapsedNs(start);
+
+    ok = checkRecords<Key, BYTES>(&records[0].key, records[0].payload, sizeof(R), sizeof(R), n);
+    return timing;
+}
+
+// Appends [record bytes, key bits, layout, sort ns, gather ns] for every layout
+template <typename Key, int BYTES>
+static void benchmarkRecords(int count, vector<jlong> &report)
+{
+    vector<Record<Key, BYTES>> input = makeRecords<Key, BYTES>(count);
+    for (int layout = LAYOUT_AOS; layout <= LAYOUT_KEY_INDEX; layout++)
+    {
+        bool ok = true;
+        RecordSortTiming timing;
+        if (layout == LAYOUT_AOS)
+            timing = sortArrayOfStructs<Key, BYTES>(input, ok);
+        else if (layout == LAYOUT_SOA)
+            timing = sortStructOfArrays<Key, BYTES>(input, ok);
+        else
+            timing = sortKeyIndexPairs<Key, BYTES>(input, ok);
+        if (!ok)
+            LOGE("Layout %d with %d byte records and %d bit keys is not sorted", layout, BYTES, (int) sizeof(Key) * 8);
+
+        report.push_back(BYTES);
+        report.push_back(sizeof(Key) * 8);
+        report.push_back(layout);
+        report.push_back(timing.sortNs);
+        report.push_back(timing.gatherNs);
+    }
+}
+
+// Sorts recordCount records for every record size, key width and layout.
+// Returns rows of [record bytes, key bits, layout, sort ns, gather ns]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runRecordSortBenchmark(JNIEnv *env, jobject, jint recordCount)
+{
+    int count = max(1, (int) recordCount);
+    vector<jlong> report;
+    benchmarkRecords<uint32_t, 16>(count, report);
+    benchmarkRecords<uint32_t, 32>(count, report);
+    benchmarkRecords<uint32_t, 64>(count, report);
+    benchmarkRecords<uint64_t, 16>(count, report);
+    benchmarkRecords<uint64_t, 32>(count, report);
+    benchmarkRecords<uint64_t, 64>(count, report);
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
@@ -0,0 +1,720 @@
+//
+// SIMD sorting networks for 8, 16 and 32 element blocks, used as the leaves
+// of quicksort and merge sort.
+//
+// A block is held in registers. Every register is sorted in place by an
+// in-register network (bitonic or Batcher odd-even), then registers are
+// merged pairwise by the same family of network:
+//   bitonic:  reverse the second run, min/max across registers, then a
+//             bitonic clean inside each register
+//   odd-even: Batcher's merge, min/max across registers for distances of a
+//             whole register or more; below that the comparators straddle
+//             register boundaries, so the run is shifted by the distance,
+//             cleaned in-register and shifted back
+// One in-register step is always permute + min + max + blend.
+//
+#include <jni.h>
+#include <vector>
+#include <chrono>
+#include <climits>
+#include <utility>
+#include <algorithm>
+#include <android/log.h>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+#include "../includes/sortingAlg.hpp"
+
+#define LOG_TAG "SimdSort"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const int NETWORK_LEAF_SIZE = 32;
+static const int MAX_LANES = 4;
+static const int MAX_BLOCK_REGISTERS = NETWORK_LEAF_SIZE / MAX_LANES;
+
+// One network layer: lane i is compared with lane partner[i] and keeps the
+// larger value when takeMax[i] is set. Lanes outside the layer are their own partner.
+struct NetworkLayer {
+    int partner[MAX_LANES];
+    bool takeMax[MAX_LANES];
+};
+
+// Comparator (lo, hi): the minimum ends up in lane lo, the maximum in lane hi
+typedef vector<pair<int, int>> ComparatorList;
+
+static NetworkLayer makeLayer(int lanes, const ComparatorList &comparators)
+{
+    NetworkLayer layer;
+    for (int i = 0; i < lanes; i++)
+    {
+        layer.partner[i] = i;
+        layer.takeMax[i] = false;
+    }
+    for (const pair<int, int> &c : comparators)
+    {
+        layer.partner[c.first] = c.second;
+        layer.partner[c.second] = c.first;
+        layer.takeMax[c.second] = true;
+    }
+    return layer;
+}
+
+static vector<ComparatorList> bitonicSortLayers(int lanes)
+{
+    vector<ComparatorList> layers;
+    for (int k = 2; k <= lanes; k *= 2)
+    {
+        for (int j = k / 2; j > 0; j /= 2)
+        {
+            ComparatorList layer;
+            for (int i = 0; i < lanes; i++)
+            {
+                int l = i ^ j;
+                if (l > i)
+                    layer.push_back((i & k) == 0 ? make_pair(i, l) : make_pair(l, i));
+            }
+            layers.push_back(layer);
+        }
+    }
+    return layers;
+}
+
+static vector<ComparatorList> oddEvenSortLayers(int lanes)
+{
+    vector<ComparatorList> layers;
+    for (int p = 1; p < lanes; p *= 2)
+    {
+        for (int k = p; k >= 1; k /= 2)
+        {
+            ComparatorList layer;
+            for (int j = k % p; j + k < lanes; j += 2 * k)
+            {
+                for (int i = 0; i < min(k, lanes - j - k); i++)
+                {
+                    if ((i + j) / (2 * p) == (i + j + k) / (2 * p))
+                        layer.push_back(make_pair(i + j, i + j + k));
+                }
+            }
+            layers.push_back(layer);
+        }
+    }
+    return layers;
+}
+
+// Sorts a bitonic register: half-cleaners at lane distance lanes/2 .. 1
+static vector<ComparatorList> bitonicCleanLayers(int lanes)
+{
+    vector<ComparatorList> layers;
+    for (int j = lanes / 2; j > 0; j /= 2)
+    {
+        ComparatorList layer;
+        for (int i = 0; i < lanes; i++)
+        {
+            if ((i & j) == 0)
+                layer.push_back(make_pair(i, i ^ j));
+        }
+        layers.push_back(layer);
+    }
+    return layers;
+}
+
+// ----------------------------------------------------------------------------
+// Lane backends. Each one provides V (register), Perm and Mask (prepared
+// constants), load/store, vmin/vmax, permute, select(mask, ifSet, ifClear)
+// and shiftIn(lo, hi, n): lanes n.. of lo followed by lanes ..n-1 of hi.
+// ----------------------------------------------------------------------------
+
+struct ScalarLanes {
+    static const int W = 4;
+    struct V { int lane[W]; };
+    struct Perm { int index[W]; };
+    struct Mask { bool set[W]; };
+
+    static const char *name() { return "Scalar"; }
+    static V load(const int *p) { V v; for (int i = 0; i < W; i++) v.lane[i] = p[i]; return v; }
+    static void store(int *p, V v) { for (int i = 0; i < W; i++) p[i] = v.lane[i]; }
+    static V vmin(V a, V b) { for (int i = 0; i < W; i++) a.lane[i] = min(a.lane[i], b.lane[i]); return a; }
+    static V vmax(V a, V b) { for (int i = 0; i < W; i++) a.lane[i] = max(a.lane[i], b.lane[i]); return a; }
+    static V permute(V v, const Perm &perm) { V r; for (int i = 0; i < W; i++) r.lane[i] = v.lane[perm.index[i]]; return r; }
+    static V select(const Mask &mask, V a, V b) { for (int i = 0; i < W; i++) if (!mask.set[i]) a.lane[i] = b.lane[i]; return a; }
+    static V shiftIn(V lo, V hi, int n) { V r; for (int i = 0; i < W; i++) r.lane[i] = i + n < W ? lo.lane[i + n] : hi.lane[i + n - W]; return r; }
+    static Perm makePerm(const int *index) { Perm p; for (int i = 0; i < W; i++) p.index[i] = index[i]; return p; }
+    static Mask makeMask(const bool *set) { Mask m; for (int i = 0; i < W; i++) m.set[i] = set[i]; return m; }
+};
+
+#if defined(__ARM_NEON)
+struct NeonLanes {
+    static const int W = 4;
+    typedef int32x4_t V;
+    typedef uint8x16_t Perm;
+    typedef uint32x4_t Mask;
+
+    static const char *name() { return "NEON"; }
+    static V load(const int *p) { return vld1q_s32(p); }
+    static void store(int *p, V v) { vst1q_s32(p, v); }
+    static V vmin(V a, V b) { return vminq_s32(a, b); }
+    static V vmax(V a, V b) { return vmaxq_s32(a, b); }
+    static V permute(V v, const Perm &perm)
+    {
+#if defined(__aarch64__)
+        return vreinterpretq_s32_u8(vqtbl1q_u8(vreinterpretq_u8_s32(v), perm));
+#else
+        uint8x16_t bytes = vreinterpretq_u8_s32(v);
+        uint8x8x2_t table = {{vget_low_u8(bytes), vget_high_u8(bytes)}};
+        return vreinterpretq_s32_u8(vcombine_u8(vtbl2_u8(table, vget_low_u8(perm)),
+                                                vtbl2_u8(table, vget_high_u8(perm))));
+#endif
+    }
+    static V select(const Mask &mask, V a, V b) { return vbslq_s32(mask, a, b); }
+    static V shiftIn(V lo, V hi, int n)
+    {
+        // The lane count is an immediate
+        switch (n)
+        {
+            case 1: return vextq_s32(lo, hi, 1);
+            case 2: return vextq_s32(lo, hi, 2);
+            default: return vextq_s32(lo, hi, 3);
+        }
+    }
+    static Perm makePerm(const int *index)
+    {
+        uint8_t bytes[16];
+        for (int i = 0; i < 16; i++)
+            bytes[i] = (uint8_t) (index[i / 4] * 4 + i % 4);
+        return vld1q_u8(bytes);
+    }
+    static Mask makeMask(const bool *set)
+    {
+        uint32_t lanes[4];
+        for (int i = 0; i < 4; i++)
+            lanes[i] = set[i] ? 0xFFFFFFFFu : 0u;
+        return vld1q_u32(lanes);
+    }
+};
+#endif
+
+#if defined(__SSE4_1__)
+struct SseLanes {
+    static const int W = 4;
+    typedef __m128i V;
+    typedef __m128i Perm;
+    typedef __m128i Mask;
+
+    static const char *name() { return "SSE4.1"; }
+    static V load(const int *p) { return _mm_loadu_si128((const __m128i *) p); }
+    static void store(int *p, V v) { _mm_storeu_si128((__m128i *) p, v); }
+    static V vmin(V a, V b) { return _mm_min_epi32(a, b); }
+    static V vmax(V a, V b) { return _mm_max_epi32(a, b); }
+    static V permute(V v, const Perm &perm) { return _mm_shuffle_epi8(v, perm); }
+    static V select(const Mask &mask, V a, V b) { return _mm_blendv_epi8(b, a, mask); }
+    static V shiftIn(V lo, V hi, int n)
+    {
+        // The byte count is an immediate
+        switch (n)
+        {
+            case 1: return _mm_alignr_epi8(hi, lo, 4);
+            case 2: return _mm_alignr_epi8(hi, lo, 8);
+            default: return _mm_alignr_epi8(hi, lo, 12);
+        }
+    }
+    static Perm makePerm(const int *index)
+    {
+        alignas(16) int8_t bytes[16];
+        for (int i = 0; i < 16; i++)
+            bytes[i] = (int8_t) (index[i / 4] * 4 + i % 4);
+        return _mm_load_si128((const __m128i *) bytes);
+    }
+    static Mask makeMask(const bool *set)
+    {
+        return _mm_setr_epi32(set[0] ? -1 : 0, set[1] ? -1 : 0, set[2] ? -1 : 0, set[3] ? -1 : 0);
+    }
+};
+#endif
+
+// Widest backend this build was compiled for. No 8-lane AVX2 backend: the
+// Android x86_64 baseline stops at SSE4.2, and a runtime-dispatched AVX2
+// copy of these templates would need every kernel on its call path built
+// for AVX2.
+#if defined(__SSE4_1__)
+typedef SseLanes NativeLanes;
+#elif defined(__ARM_NEON)
+typedef NeonLanes NativeLanes;
+#else
+typedef ScalarLanes NativeLanes;
+#endif
+
+// ----------------------------------------------------------------------------
+// Kernels
+// ----------------------------------------------------------------------------
+
+template <class S>
+struct PreparedLayer {
+    typename S::Perm perm;
+    typename S::Mask mask;
+};
+
+template <class S>
+struct PreparedNetworks {
+    vector<PreparedLayer<S>> sort[2];   // indexed by SortingNetwork
+    vector<PreparedLayer<S>> clean;     // half-cleaners at distance W/2 .. 1
+    typename S::Perm reverse;
+    typename S::V infinity;             // every lane INT_MAX
+    long sortComparators[2] = {0, 0};
+    long cleanComparators = 0;
+};
+
+template <class S>
+static vector<PreparedLayer<S>> prepareLayers(const vector<ComparatorList> &layers, long &comparators)
+{
+    vector<PreparedLayer<S>> prepared;
+    for (const ComparatorList &comparatorList : layers)
+    {
+        NetworkLayer layer = makeLayer(S::W, comparatorList);
+        prepared.push_back({S::makePerm(layer.partner), S::makeMask(layer.takeMax)});
+        comparators += comparatorList.size();
+    }
+    return prepared;
+}
+
+template <class S>
+static const PreparedNetworks<S> &networks()
+{
+    static const PreparedNetworks<S> prepared = []() {
+        PreparedNetworks<S> n;
+        n.sort[NETWORK_BITONIC] = prepareLayers<S>(bitonicSortLayers(S::W), n.sortComparators[NETWORK_BITONIC]);
+        n.sort[NETWORK_ODD_EVEN] = prepareLayers<S>(oddEvenSortLayers(S::W), n.sortComparators[NETWORK_ODD_EVEN]);
+        n.clean = prepareLayers<S>(bitonicCleanLayers(S::W), n.cleanComparators);
+        int reversed[MAX_LANES];
+        int infinity[MAX_LANES];
+        for (int i = 0; i < S::W; i++)
+        {
+            reversed[i] = S::W - 1 - i;
+            infinity[i] = INT_MAX;
+        }
+        n.reverse = S::makePerm(reversed);
+        n.infinity = S::load(infinity);
+        return n;
+    }();
+    return prepared;
+}
+
+template <class S>
+static inline typename S::V applyLayer(typename S::V v, const PreparedLayer<S> &layer)
+{
+    typename S::V partner = S::permute(v, layer.perm);
+    return S::select(layer.mask, S::vmax(v, partner), S::vmin(v, partner));
+}
+
+template <class S>
+static inline typename S::V applyLayers(typename S::V v, const vector<PreparedLayer<S>> &layers)
+{
+    for (const PreparedLayer<S> &layer : layers)
+        v = applyLayer<S>(v, layer);
+    return v;
+}
+
+template <class S>
+static inline void compareRegisters(typename S::V &lo, typename S::V &hi)
+{
+    typename S::V low = S::vmin(lo, hi);
+    hi = S::vmax(lo, hi);
+    lo = low;
+}
+
+// Bitonic merge kernel: r[0, k) and r[k, 2k) are sorted runs of k registers,
+// on return r[0, 2k) is one sorted run
+template <class S>
+static inline void bitonicMergeRegisters(typename S::V *r, int k, const PreparedNetworks<S> &net)
+{
+    // Reversing the second run makes the whole sequence bitonic
+    for (int i = 0; i < k / 2; i++)
+        swap(r[k + i], r[2 * k - 1 - i]);
+    for (int i = k; i < 2 * k; i++)
+        r[i] = S::permute(r[i], net.reverse);
+
+    for (int distance = k; distance >= 1; distance /= 2)
+    {
+        for (int i = 0; i < 2 * k; i++)
+        {
+            if ((i & distance) == 0)
+                compareRegisters<S>(r[i], r[i + distance]);
+        }
+    }
+    for (int i = 0; i < 2 * k; i++)
+        r[i] = applyLayers<S>(r[i], net.clean);
+}
+
+// Batcher odd-even merge kernel, same contract. After the first layer
+// (element x against x + n/2) every layer at distance d compares x with
+// x + d for the x whose x / d is odd. With d below the register width those
+// pairs straddle registers; seen from a run shifted left by d lanes they are
+// exactly the in-register half-cleaner at distance d, padded with INT_MAX
+// past the end.
+template <class S>
+static inline void oddEvenMergeRegisters(typename S::V *r, int k, const PreparedNetworks<S> &net)
+{
+    const int W = S::W;
+    int registers = 2 * k;
+    for (int i = 0; i < k; i++)
+        compareRegisters<S>(r[i], r[i + k]);
+
+    for (int distance = k / 2; distance >= 1; distance /= 2)
+    {
+        for (int i = distance; i + distance < registers; i += 2 * distance)
+        {
+            for (int j = i; j < i + distance; j++)
+                compareRegisters<S>(r[j], r[j + distance]);
+        }
+    }
+
+    // net.clean[c] is the half-cleaner at lane distance W >> (c + 1)
+    typename S::V shifted[MAX_BLOCK_REGISTERS];
+    for (int c = 0; c < (int) net.clean.size(); c++)
+    {
+        int d = W >> (c + 1);
+        for (int i = 0; i < registers; i++)
+        {
+            typename S::V next = i + 1 < registers ? r[i + 1] : net.infinity;
+            shifted[i] = applyLayer<S>(S::shiftIn(r[i], next, d), net.clean[c]);
+        }
+        // The first d lanes were not part of the layer
+        typename S::V previous = S::shiftIn(r[0], r[0], d);
+        for (int i = 0; i < registers; i++)
+        {
+            r[i] = S::shiftIn(previous, shifted[i], W - d);
+            previous = shifted[i];
+        }
+    }
+}
+
+template <class S>
+static inline void mergeRegisters(typename S::V *r, int k, SortingNetwork network, const PreparedNetworks<S> &net)
+{
+    if (network == NETWORK_ODD_EVEN)
+        oddEvenMergeRegisters<S>(r, k, net);
+    else
+        bitonicMergeRegisters<S>(r, k, net);
+}
+
+// Comparator count of mergeRegisters, for the metrics policy
+template <class S>
+static long mergeComparators(int k, SortingNetwork network, const PreparedNetworks<S> &net)
+{
+    long n = 2L * k * S::W;
+    if (network == NETWORK_ODD_EVEN)
+    {
+        // n/2 for the first layer, then n/2 - d for every d from n/4 down to 1
+        long comparators = n / 2;
+        for (long d = n / 4; d >= 1; d /= 2)
+            comparators += n / 2 - d;
+        return comparators;
+    }
+    long levels = 0;
+    for (int distance = k; distance >= 1; distance /= 2)
+        levels++;
+    return levels * k * S::W + 2 * k * net.cleanComparators;
+}
+
+// Sorts blockSize (8, 16 or 32) elements in place
+template <class S, typename Metrics>
+static void sortBlock(int *data, int blockSize, SortingNetwork network, Metrics &metrics)
+{
+    const PreparedNetworks<S> &net = networks<S>();
+    int registers = blockSize / S::W;
+    typename S::V r[MAX_BLOCK_REGISTERS];
+
+    for (int i = 0; i < registers; i++)
+        r[i] = applyLayers<S>(S::load(data + i * S::W), net.sort[network]);
+    metrics.comparison += registers * net.sortComparators[network];
+
+    for (int k = 1; k < registers; k *= 2)
+    {
+        for (int base = 0; base < registers; base += 2 * k)
+            mergeRegisters<S>(r + base, k, network, net);
+        metrics.comparison += registers / (2 * k) * mergeComparators<S>(k, network, net);
+    }
+
+    for (int i = 0; i < registers; i++)
+        S::store(data + i * S::W, r[i]);
+    metrics.assigments += blockSize;
+}
+
+// Sorts up to NETWORK_LEAF_SIZE elements, padding to the next block size with INT_MAX
+template <class S, typename Metrics>
+static void networkLeafSort(int *data, int length, SortingNetwork network, Metrics &metrics)
+{
+    if (length < 2)
+        return;
+    int blockSize = max(S::W, 8);
+    while (blockSize < length)
+        blockSize *= 2;
+
+    alignas(64) int block[NETWORK_LEAF_SIZE];
+    copy(data, data + length, block);
+    fill(block + length, block + blockSize, INT_MAX);
+    sortBlock<S>(block, blockSize, network, metrics);
+    copy(block, block + length, data);
+    metrics.assigments += 2 * length;
+}
+
+// Merges two sorted runs whose lengths are multiples of W, one register from
+// each run at a time: the lower half of every 2-register merge is final, the
+// upper half waits for the next register from whichever run is behind.
+template <class S, typename Metrics>
+static void simdMergeRuns(const int *a, int lengthA, const int *b, int lengthB, int *out, SortingNetwork network,
+                          Metrics &metrics)
+{
+    const PreparedNetworks<S> &net = networks<S>();
+    const int W = S::W;
+    if (lengthA == 0 || lengthB == 0)
+    {
+        const int *rest = lengthA == 0 ? b : a;
+        copy(rest, rest + lengthA + lengthB, out);
+        metrics.assigments += lengthA + lengthB;
+        return;
+    }
+
+    typename S::V r[2];
+    r[0] = S::load(a);
+    r[1] = S::load(b);
+    int ia = W;
+    int ib = W;
+    long merges = 0;
+    while (true)
+    {
+        mergeRegisters<S>(r, 1, network, net);
+        merges++;
+        S::store(out, r[0]);
+        out += W;
+        r[0] = r[1];
+
+        if (ia < lengthA && (ib >= lengthB || a[ia] <= b[ib]))
+        {
+            r[1] = S::load(a + ia);
+            ia += W;
+        }
+        else if (ib < lengthB)
+        {
+            r[1] = S::load(b + ib);
+            ib += W;
+        }
+        else
+        {
+            break;
+        }
+    }
+    S::store(out, r[0]);
+
+    metrics.comparison += merges * (mergeComparators<S>(1, network, net) + 1);
+    metrics.assigments += lengthA + lengthB;
+}
+
+// ----------------------------------------------------------------------------
+// Drivers. The leaf phase runs separately from the partition/merge phase so
+// the benchmark can report how much of the total the small ranges cost.
+// ----------------------------------------------------------------------------
+
+static inline SortingNetwork leafNetwork(LeafKernel leaf)
+{
+    return leaf == LEAF_NETWORK_BITONIC ? NETWORK_BITONIC : NETWORK_ODD_EVEN;
+}
+
+template <typename Metrics>
+static void sortLeaf(IntSpan array, int begin, int end, LeafKernel leaf, Metrics &metrics)
+{
+    if (leaf == LEAF_INSERTION)
+        insertionSortRange(array, begin, end, metrics);
+    else
+        networkLeafSort<NativeLanes>(array.data() + begin, end - begin, leafNetwork(leaf), metrics);
+}
+
+// Median-of-3 Hoare quicksort that stops at NETWORK_LEAF_SIZE and records the leaves
+template <typename Metrics>
+static void quickPartitionPhase(IntSpan array, int begin, int end, int depthLimit,
+                                vector<pair<int, int>> &leaves, Metrics &metrics)
+{
+    while (end - begin > NETWORK_LEAF_SIZE)
+    {
+        if (depthLimit == 0)
+        {
+            heapSortRange(array, begin, end, metrics);
+            return;
+        }
+        depthLimit--;
+
+        int mid = begin + (end - begin) / 2;
+        if (lessThan(array[mid], array[begin], metrics)) swapCounted(array[begin], array[mid], metrics);
+        if (lessThan(array[end - 1], array[mid], metrics)) swapCounted(array[mid], array[end - 1], metrics);
+        if (lessThan(array[mid], array[begin], metrics)) swapCounted(array[begin], array[mid], metrics);
+        int pivot = array[mid];
+
+        int i = begin - 1;
+        int j = end;
+        while (true)
+        {
+            do { i++; } while (lessThan(array[i], pivot, metrics));
+            do { j--; } while (lessThan(pivot, array[j], metrics));
+            if (i >= j)
+                break;
+            swapCounted(array[i], array[j], metrics);
+        }
+
+        if (j + 1 - begin < end - (j + 1))
+        {
+            quickPartitionPhase(array, begin, j + 1, depthLimit, leaves, metrics);
+            begin = j + 1;
+        }
+        else
+        {
+            quickPartitionPhase(array, j + 1, end, depthLimit, leaves, metrics);
+            end = j + 1;
+        }
+    }
+    leaves.push_back(make_pair(begin, end));
+}
+
+template <typename Metrics>
+LeafSortTiming quickSortWithLeaves(IntSpan array, LeafKernel leaf, Metrics &metrics)
+{
+    LeafSortTiming timing;
+    int n = array.size();
+    int depthLimit = 0;
+    for (int m = n; m > 1; m >>= 1)
+        depthLimit += 2;
+
+    vector<pair<int, int>> leaves;
+    auto start = chrono::high_resolution_clock::now();
+    quickPartitionPhase(array, 0, n, depthLimit, leaves, metrics);
+    auto middle = chrono::high_resolution_clock::now();
+    for (const pair<int, int> &range : leaves)
+        sortLeaf(array, range.first, range.second, leaf, metrics);
+    auto end = chrono::high_resolution_clock::now();
+
+    timing.leafMs = chrono::duration<double, milli>(end - middle).count();
+    timing.totalMs = chrono::duration<double, milli>(end - start).count();
+    return timing;
+}
+
+// Both halves of the merge ping-pong, kept between calls on the same thread
+static thread_local vector<int> mergeFront, mergeBack;
+
+void releaseSimdMergeScratch()
+{
+    vector<int>().swap(mergeFront);
+    vector<int>().swap(mergeBack);
+}
+
+template <typename Metrics>
+LeafSortTiming mergeSortWithLeaves(IntSpan array, LeafKernel leaf, Metrics &metrics)
+{
+    LeafSortTiming timing;
+    int n = array.size();
+    if (n < 2)
+        return timing;
+
+    // Padding to whole leaves keeps every run a multiple of the register width
+    int padded = (n + NETWORK_LEAF_SIZE - 1) / NETWORK_LEAF_SIZE * NETWORK_LEAF_SIZE;
+    vector<int> &front = mergeFront;
+    vector<int> &back = mergeBack;
+    front.assign(array.begin(), array.end());
+    front.resize(padded, INT_MAX);
+    back.resize(padded);
+    metrics.assigments += padded;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int lo = 0; lo < padded; lo += NETWORK_LEAF_SIZE)
+        sortLeaf(front, lo, lo + NETWORK_LEAF_SIZE, leaf, metrics);
+    auto middle = chrono::high_resolution_clock::now();
+
+    int *src = front.data();
+    int *dst = back.data();
+    for (int width = NETWORK_LEAF_SIZE; width < padded; width *= 2)
+    {
+        for (int lo = 0; lo < padded; lo += 2 * width)
+        {
+            int mid = min(lo + width, padded);
+            int hi = min(lo + 2 * width, padded);
+            if (leaf == LEAF_INSERTION)
+                mergeRuns(src, dst, lo, mid, hi, metrics);
+            else
+                simdMergeRuns<NativeLanes>(src + lo, mid - lo, src + mid, hi - mid, dst + lo, leafNetwork(leaf), metrics);
+        }
+        swap(src, dst);
+    }
+    auto end = chrono::high_resolution_clock::now();
+
+    copy(src, src + n, array.begin());
+    metrics.assigments += n;
+
+    timing.leafMs = chrono::duration<double, milli>(middle - start).count();
+    timing.totalMs = chrono::duration<double, milli>(end - start).count();
+    return timing;
+}
+
+const char *getSimdIsaName()
+{
+    return NativeLanes::name();
+}
+
+template <typename Metrics>
+void quickSortNetworkLeaves(IntSpan array, Metrics &metrics)
+{
+    quickSortWithLeaves(array, LEAF_NETWORK_BITONIC, metrics);
+}
+
+template <typename Metrics>
+void mergeSortSimd(IntSpan array, Metrics &metrics)
+{
+    mergeSortWithLeaves(array, LEAF_NETWORK_BITONIC, metrics);
+}
+
+template LeafSortTiming quickSortWithLeaves<SortMetrics>(IntSpan, LeafKernel, SortMetrics&);
+template LeafSortTiming quickSortWithLeaves<NoMetrics>(IntSpan, LeafKernel, NoMetrics&);
+template LeafSortTiming mergeSortWithLeaves<SortMetrics>(IntSpan, LeafKernel, SortMetrics&);
+template LeafSortTiming mergeSortWithLeaves<NoMetrics>(IntSpan, LeafKernel, NoMetrics&);
+INSTANTIATE_SORT_KERNEL(quickSortNetworkLeaves)
+INSTANTIATE_SORT_KERNEL(mergeSortSimd)
+
+// Quicksort and merge sort with insertion, bitonic and odd-even leaves on the same input.
+// Returns [total ms, leaf ms] for quick+insertion, quick+bitonic, quick+odd-even,
+// merge+insertion, merge+bitonic, merge+odd-even.
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runLeafKernelBenchmark(JNIEnv *env, jobject, jint arraySize)
+{
+    vector<int> original_data = generateSortInput(arraySize);
+    const LeafKernel leaves[] = {LEAF_INSERTION, LEAF_NETWORK_BITONIC, LEAF_NETWORK_ODD_EVEN};
+
+    vector<jdouble> report;
+    for (int driver = 0; driver < 2; driver++)
+    {
+        for (LeafKernel leaf : leaves)
+        {
+            vector<int> data = original_data;
+            NoMetrics metrics;
+            LeafSortTiming timing = driver == 0 ? quickSortWithLeaves(data, leaf, metrics)
+                                                : mergeSortWithLeaves(data, leaf, metrics);
+            if (!is_sorted(data.begin(), data.end()))
+                LOGI("Leaf kernel %d (driver %d) produced unsorted output", leaf, driver);
+            report.push_back(timing.totalMs);
+            report.push_back(timing.leafMs);
+        }
+    }
+    LOGI("Leaf kernel benchmark on %s, n = %d", getSimdIsaName(), arraySize);
+
+    jdoubleArray result = env->NewDoubleArray(report.size());
+    env->SetDoubleArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_example_myapplication_testCpuWithSorting_getSimdIsaName(JNIEnv *env, jobject)
+{
+    return env->NewStringUTF(getSimdIsaName());
+}
@@ -0,0 +1,673 @@
+//
+// Comparison sorts used in production code, templated over the metrics policy
+//
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include "../includes/sortingAlg.hpp"
+
+using namespace std;
+
+static const int INSERTION_SORT_THRESHOLD = 16;
+static const int PDQ_INSERTION_SORT_THRESHOLD = 24;
+static const int PDQ_NINTHER_THRESHOLD = 128;
+static const int PDQ_PARTIAL_INSERTION_LIMIT = 8;
+static const int TIMSORT_MIN_MERGE = 64;
+
+static int floorLog2(int n)
+{
+    int log = 0;
+    while (n > 1) {
+        n >>= 1;
+        log++;
+    }
+    return log;
+}
+
+// Sorts [begin, end) by straight insertion
+template <typename Metrics>
+void insertionSortRange(IntSpan array, int begin, int end, Metrics &metrics)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        int key = array[i];
+        int j = i - 1;
+        while (j >= begin && lessThan(key, array[j], metrics))
+        {
+            array[j + 1] = array[j];
+            metrics.assigments++;
+            j--;
+        }
+        array[j + 1] = key;
+        metrics.assigments += 2;
+    }
+}
+
+template <typename Metrics>
+void insertionSort(IntSpan array, Metrics &metrics)
+{
+    insertionSortRange(array, 0, array.size(), metrics);
+}
+
+// Same as insertionSortRange but relies on array[begin - 1] being a sentinel
+// that is not greater than anything in [begin, end)
+template <typename Metrics>
+static void unguardedInsertionSortRange(IntSpan array, int begin, int end, Metrics &metrics)
+{
+    for (int i = begin + 1; i < end; i++)
+    {
+        int key = array[i];
+        int j = i - 1;
+        while (lessThan(key, array[j], metrics))
+        {
+            array[j + 1] = array[j];
+            metrics.assigments++;
+            j--;
+        }
+        array[j + 1] = key;
+        metrics.assigments += 2;
+    }
+}
+
+template <typename Metrics>
+static void siftDownRange(IntSpan array, int begin, int n, int i, Metrics &metrics)
+{
+    while (true)
+    {
+        int largest = i;
+        int left = 2 * i + 1;
+        int right = 2 * i + 2;
+        if (left < n && lessThan(array[begin + largest], array[begin + left], metrics))
+            largest = left;
+        if (right < n && lessThan(array[begin + largest], array[begin + right], metrics))
+            largest = right;
+        if (largest == i)
+            return;
+        swapCounted(array[begin + i], array[begin + largest], metrics);
+        i = largest;
+    }
+}
+
+// Heap sort over [begin, end), the worst-case fallback of introsort and pdqsort
+template <typename Metrics>
+void heapSortRange(IntSpan array, int begin, int end, Metrics &metrics)
+{
+    int n = end - begin;
+    for (int i = n / 2 - 1; i >= 0; i--)
+        siftDownRange(array, begin, n, i, metrics);
+    for (int i = n - 1; i > 0; i--)
+    {
+        swapCounted(array[begin], array[begin + i], metrics);
+        siftDownRange(array, begin, i, 0, metrics);
+    }
+}
+
+// Orders array[a] <= array[b] <= array[c]
+template <typename Metrics>
+static void sort3(IntSpan array, int a, int b, int c, Metrics &metrics)
+{
+    if (lessThan(array[b], array[a], metrics)) swapCounted(array[a], array[b], metrics);
+    if (lessThan(array[c], array[b], metrics)) swapCounted(array[b], array[c], metrics);
+    if (lessThan(array[b], array[a], metrics)) swapCounted(array[a], array[b], metrics);
+}
+
+// ----------------------------------------------------------------------------
+// Introsort: median-of-3 quicksort, heap sort past 2*log2(n) levels,
+// one insertion sort pass over the nearly sorted result
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+static void introSortLoop(IntSpan array, int begin, int end, int depthLimit, Metrics &metrics)
+{
+    while (end - begin > INSERTION_SORT_THRESHOLD)
+    {
+        if (depthLimit == 0)
+        {
+            heapSortRange(array, begin, end, metrics);
+            return;
+        }
+        depthLimit--;
+
+        int mid = begin + (end - begin) / 2;
+        sort3(array, begin, mid, end - 1, metrics);
+        int pivot = array[mid];
+
+        // Hoare partition: [begin, j] <= pivot <= [j + 1, end)
+        int i = begin - 1;
+        int j = end;
+        while (true)
+        {
+            do { i++; } while (lessThan(array[i], pivot, metrics));
+            do { j--; } while (lessThan(pivot, array[j], metrics));
+            if (i >= j)
+                break;
+            swapCounted(array[i], array[j], metrics);
+        }
+
+        // Recurse into the smaller half so the stack stays O(log n)
+        if (j + 1 - begin < end - (j + 1))
+        {
+            introSortLoop(array, begin, j + 1, depthLimit, metrics);
+            begin = j + 1;
+        }
+        else
+        {
+            introSortLoop(array, j + 1, end, depthLimit, metrics);
+            end = j + 1;
+        }
+    }
+}
+
+template <typename Metrics>
+void introSort(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    if (n < 2)
+        return;
+    introSortLoop(array, 0, n, 2 * floorLog2(n), metrics);
+    insertionSortRange(array, 0, n, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// Pattern-defeating quicksort (Orson Peters): detects already partitioned
+// ranges, breaks up adversarial patterns after unbalanced partitions and
+// falls back to heap sort when that keeps happening
+// ----------------------------------------------------------------------------
+
+// Partitions around array[begin], elements equal to the pivot go right.
+// Returns the final pivot position and whether no swap was needed.
+template <typename Metrics>
+static pair<int, bool> pdqPartitionRight(IntSpan array, int begin, int end, Metrics &metrics)
+{
+    int pivot = array[begin];
+    int first = begin;
+    int last = end;
+
+    while (lessThan(array[++first], pivot, metrics));
+
+    if (first - 1 == begin)
+        while (first < last && !lessThan(array[--last], pivot, metrics));
+    else
+        while (!lessThan(array[--last], pivot, metrics));
+
+    bool alreadyPartitioned = first >= last;
+
+    while (first < last)
+    {
+        swapCounted(array[first], array[last], metrics);
+        while (lessThan(array[++first], pivot, metrics));
+        while (!lessThan(array[--last], pivot, metrics));
+    }
+
+    int pivotPos = first - 1;
+    array[begin] = array[pivotPos];
+    array[pivotPos] = pivot;
+    metrics.assigments += 3;
+    return make_pair(pivotPos, alreadyPartitioned);
+}
+
+// Partitions around array[begin], elements equal to the pivot go left.
+// Used when the pivot equals the element before the range, so the whole
+// run of equal keys is finished in one pass.
+template <typename Metrics>
+static int pdqPartitionLeft(IntSpan array, int begin, int end, Metrics &metrics)
+{
+    int pivot = array[begin];
+    int first = begin;
+    int last = end;
+
+    while (lessThan(pivot, array[--last], metrics));
+
+    if (last + 1 == end)
+        while (first < last && !lessThan(pivot, array[++first], metrics));
+    else
+        while (!lessThan(pivot, array[++first], metrics));
+
+    while (first < last)
+    {
+        swapCounted(array[first], array[last], metrics);
+        while (lessThan(pivot, array[--last], metrics));
+        while (!lessThan(pivot, array[++first], metrics));
+    }
+
+    int pivotPos = last;
+    array[begin] = array[pivotPos];
+    array[pivotPos] = pivot;
+    metrics.assigments += 3;
+    return pivotPos;
+}
+
+// Insertion sort that gives up after PDQ_PARTIAL_INSERTION_LIMIT moves.
+// Returns true if the range ended up sorted.
+template <typename Metrics>
+static bool pdqPartialInsertionSort(IntSpan array, int begin, int end, Metrics &metrics)
+{
+    if (begin == end)
+        return true;
+
+    int limit = 0;
+    for (int cur = begin + 1; cur != end; cur++)
+    {
+        if (limit > PDQ_PARTIAL_INSERTION_LIMIT)
+            return false;
+
+        int sift = cur;
+        if (lessThan(array[sift], array[sift - 1], metrics))
+        {
+            int tmp = array[sift];
+            do {
+                array[sift] = array[sift - 1];
+                metrics.assigments++;
+                sift--;
+            } while (sift != begin && lessThan(tmp, array[sift - 1], metrics));
+            array[sift] = tmp;
+            metrics.assigments += 2;
+            limit += cur - sift;
+        }
+    }
+    return true;
+}
+
+template <typename Metrics>
+static void pdqSortLoop(IntSpan array, int begin, int end, int badAllowed, bool leftmost, Metrics &metrics)
+{
+    while (true)
+    {
+        int size = end - begin;
+        if (size < PDQ_INSERTION_SORT_THRESHOLD)
+        {
+            if (leftmost)
+                insertionSortRange(array, begin, end, metrics);
+            else
+                unguardedInsertionSortRange(array, begin, end, metrics);
+            return;
+        }
+
+        // Pivot: median of 3, or pseudo-median of 9 (Tukey's ninther) on large ranges
+        int half = size / 2;
+        if (size > PDQ_NINTHER_THRESHOLD)
+        {
+            sort3(array, begin, begin + half, end - 1, metrics);
+            sort3(array, begin + 1, begin + (half - 1), end - 2, metrics);
+            sort3(array, begin + 2, begin + (half + 1), end - 3, metrics);
+            sort3(array, begin + (half - 1), begin + half, begin + (half + 1), metrics);
+            swapCounted(array[begin], array[begin + half], metrics);
+        }
+        else
+        {
+            sort3(array, begin + half, begin, end - 1, metrics);
+        }
+
+        // The element left of the range is a previous pivot. If it equals this
+        // pivot, everything equal to it can be put in place at once.
+        if (!leftmost && !lessThan(array[begin - 1], array[begin], metrics))
+        {
+            begin = pdqPartitionLeft(array, begin, end, metrics) + 1;
+            continue;
+        }
+
+        pair<int, bool> partition = pdqPartitionRight(array, begin, end, metrics);
+        int pivotPos = partition.first;
+        bool alreadyPartitioned = partition.second;
+
+        int leftSize = pivotPos - begin;
+        int rightSize = end - (pivotPos + 1);
+        bool highlyUnbalanced = leftSize < size / 8 || rightSize < size / 8;
+
+        if (highlyUnbalanced)
+        {
+            if (--badAllowed == 0)
+            {
+                heapSortRange(array, begin, end, metrics);
+                return;
+            }
+
+            // Shuffle a few elements to break the pattern that caused the bad pivot
+            if (leftSize >= PDQ_INSERTION_SORT_THRESHOLD)
+            {
+                swapCounted(array[begin], array[begin + leftSize / 4], metrics);
+                swapCounted(array[pivotPos - 1], array[pivotPos - leftSize / 4], metrics);
+                if (leftSize > PDQ_NINTHER_THRESHOLD)
+                {
+                    swapCounted(array[begin + 1], array[begin + (leftSize / 4 + 1)], metrics);
+                    swapCounted(array[begin + 2], array[begin + (leftSize / 4 + 2)], metrics);
+                    swapCounted(array[pivotPos - 2], array[pivotPos - (leftSize / 4 + 1)], metrics);
+                    swapCounted(array[pivotPos - 3], array[pivotPos - (leftSize / 4 + 2)], metrics);
+                }
+            }
+            if (rightSize >= PDQ_INSERTION_SORT_THRESHOLD)
+            {
+                swapCounted(array[pivotPos + 1], array[pivotPos + (1 + rightSize / 4)], metrics);
+                swapCounted(array[end - 1], array[end - rightSize / 4], metrics);
+                if (rightSize > PDQ_NINTHER_THRESHOLD)
+                {
+                    swapCounted(array[pivotPos + 2], array[pivotPos + (2 + rightSize / 4)], metrics);
+                    swapCounted(array[pivotPos + 3], array[pivotPos + (3 + rightSize / 4)], metrics);
+                    swapCounted(array[end - 2], array[end - (1 + rightSize / 4)], metrics);
+                    swapCounted(array[end - 3], array[end - (2 + rightSize / 4)], metrics);
+                }
+            }
+        }
+        else if (alreadyPartitioned &&
+                 pdqPartialInsertionSort(array, begin, pivotPos, metrics) &&
+                 pdqPartialInsertionSort(array, pivotPos + 1, end, metrics))
+        {
+            // Balanced partition with no swaps: the input was most likely sorted
+            return;
+        }
+
+        pdqSortLoop(array, begin, pivotPos, badAllowed, leftmost, metrics);
+        begin = pivotPos + 1;
+        leftmost = false;
+    }
+}
+
+template <typename Metrics>
+void pdqSort(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    if (n < 2)
+        return;
+    pdqSortLoop(array, 0, n, floorLog2(n), true, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// Merge sorts sharing one scratch buffer. The buffer only grows, so repeated
+// benchmark runs on the same thread don't pay for the allocation again.
+// ----------------------------------------------------------------------------
+
+static thread_local vector<int> mergeScratch;
+
+static vector<int> &mergeBuffer(size_t size)
+{
+    if (mergeScratch.size() < size)
+        mergeScratch.resize(size);
+    return mergeScratch;
+}
+
+void releaseMergeScratch()
+{
+    vector<int>().swap(mergeScratch);
+}
+
+// Stable merge of src[lo, mid) and src[mid, hi) into dst[lo, hi)
+template <typename Metrics>
+void mergeRuns(const int *src, int *dst, int lo, int mid, int hi, Metrics &metrics)
+{
+    int i = lo;
+    int j = mid;
+    int k = lo;
+    while (i < mid && j < hi)
+    {
+        if (lessThan(src[j], src[i], metrics))
+            dst[k++] = src[j++];
+        else
+            dst[k++] = src[i++];
+    }
+    while (i < mid)
+        dst[k++] = src[i++];
+    while (j < hi)
+        dst[k++] = src[j++];
+    metrics.assigments += hi - lo;
+}
+
+template <typename Metrics>
+void mergeSortBottomUp(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    if (n < 2)
+        return;
+
+    // Short runs are cheaper to build with insertion sort than with 4 merge passes
+    for (int lo = 0; lo < n; lo += INSERTION_SORT_THRESHOLD)
+        insertionSortRange(array, lo, min(lo + INSERTION_SORT_THRESHOLD, n), metrics);
+
+    vector<int> &buffer = mergeBuffer(n);
+    int *src = array.data();
+    int *dst = buffer.data();
+    for (int width = INSERTION_SORT_THRESHOLD; width < n; width *= 2)
+    {
+        for (int lo = 0; lo < n; lo += 2 * width)
+        {
+            int mid = min(lo + width, n);
+            int hi = min(lo + 2 * width, n);
+            mergeRuns(src, dst, lo, mid, hi, metrics);
+        }
+        swap(src, dst);
+    }
+
+    if (src != array.data())
+    {
+        copy(src, src + n, array.data());
+        metrics.assigments += n;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Timsort: natural runs extended to minRun with binary insertion, merged
+// under the run-length stack invariants. Galloping is reduced to trimming
+// the parts of both runs that are already in place before each merge.
+// ----------------------------------------------------------------------------
+
+struct TimRun {
+    int base;
+    int length;
+};
+
+static int timMinRun(int n)
+{
+    int r = 0;
+    while (n >= TIMSORT_MIN_MERGE)
+    {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+// Returns the length of the run starting at lo, reversing it if it is strictly descending
+template <typename Metrics>
+static int timCountRun(IntSpan array, int lo, int hi, Metrics &metrics)
+{
+    int runHi = lo + 1;
+    if (runHi == hi)
+        return 1;
+
+    if (lessThan(array[runHi++], array[lo], metrics))
+    {
+        while (runHi < hi && lessThan(array[runHi], array[runHi - 1], metrics))
+            runHi++;
+        reverse(array.begin() + lo, array.begin() + runHi);
+        metrics.assigments += runHi - lo;
+    }
+    else
+    {
+        while (runHi < hi && !lessThan(array[runHi], array[runHi - 1], metrics))
+            runHi++;
+    }
+    return runHi - lo;
+}
+
+// Extends the sorted prefix [lo, start) to [lo, hi)
+template <typename Metrics>
+static void timBinaryInsertionSort(IntSpan array, int lo, int hi, int start, Metrics &metrics)
+{
+    for (int i = start; i < hi; i++)
+    {
+        int key = array[i];
+        int left = lo;
+        int right = i;
+        while (left < right)
+        {
+            int mid = left + (right - left) / 2;
+            if (lessThan(key, array[mid], metrics))
+                right = mid;
+            else
+                left = mid + 1;
+        }
+        for (int j = i; j > left; j--)
+            array[j] = array[j - 1];
+        array[left] = key;
+        metrics.assigments += i - left + 2;
+    }
+}
+
+// First index in [lo, hi) whose element is greater than key
+template <typename Metrics>
+static int timUpperBound(IntSpan array, int lo, int hi, int key, Metrics &metrics)
+{
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (lessThan(key, array[mid], metrics))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+// First index in [lo, hi) whose element is not less than key
+template <typename Metrics>
+static int timLowerBound(IntSpan array, int lo, int hi, int key, Metrics &metrics)
+{
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (lessThan(array[mid], key, metrics))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template <typename Metrics>
+static void timMergeAt(IntSpan array, vector<TimRun> &runs, int i, Metrics &metrics)
+{
+    int base1 = runs[i].base;
+    int len1 = runs[i].length;
+    int base2 = runs[i + 1].base;
+    int len2 = runs[i + 1].length;
+
+    runs[i].length = len1 + len2;
+    runs.erase(runs.begin() + i + 1);
+
+    // Elements of run1 not greater than run2[0] are already in place
+    int start = timUpperBound(array, base1, base1 + len1, array[base2], metrics);
+    // Elements of run2 not less than run1's last are already in place
+    int end = timLowerBound(array, base2, base2 + len2, array[base1 + len1 - 1], metrics);
+    if (start == base1 + len1 || end == base2)
+        return;
+
+    int leftLength = base2 - start;
+    vector<int> &buffer = mergeBuffer(leftLength);
+    copy(array.begin() + start, array.begin() + base2, buffer.begin());
+    metrics.assigments += leftLength;
+
+    int a = 0;
+    int b = base2;
+    int k = start;
+    while (a < leftLength && b < end)
+    {
+        if (lessThan(array[b], buffer[a], metrics))
+            array[k++] = array[b++];
+        else
+            array[k++] = buffer[a++];
+        metrics.assigments++;
+    }
+    while (a < leftLength)
+    {
+        array[k++] = buffer[a++];
+        metrics.assigments++;
+    }
+}
+
+template <typename Metrics>
+static void timMergeCollapse(IntSpan array, vector<TimRun> &runs, Metrics &metrics)
+{
+    while (runs.size() > 1)
+    {
+        int n = runs.size() - 2;
+        if ((n > 0 && runs[n - 1].length <= runs[n].length + runs[n + 1].length) ||
+            (n > 1 && runs[n - 2].length <= runs[n - 1].length + runs[n].length))
+        {
+            if (runs[n - 1].length < runs[n + 1].length)
+                n--;
+        }
+        else if (runs[n].length > runs[n + 1].length)
+        {
+            break;
+        }
+        timMergeAt(array, runs, n, metrics);
+    }
+}
+
+template <typename Metrics>
+void timSort(IntSpan array, Metrics &metrics)
+{
+    int n = array.size();
+    if (n < 2)
+        return;
+
+    int minRun = timMinRun(n);
+    vector<TimRun> runs;
+    int lo = 0;
+    while (lo < n)
+    {
+        int runLength = timCountRun(array, lo, n, metrics);
+        if (runLength < minRun)
+        {
+            int forced = min(minRun, n - lo);
+            timBinaryInsertionSort(array, lo, lo + forced, lo + runLength, metrics);
+            runLength = forced;
+        }
+        runs.push_back({lo, runLength});
+        timMergeCollapse(array, runs, metrics);
+        lo += runLength;
+    }
+
+    while (runs.size() > 1)
+    {
+        int i = runs.size() - 2;
+        if (i > 0 && runs[i - 1].length < runs[i + 1].length)
+            i--;
+        timMergeAt(array, runs, i, metrics);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Standard library baselines. Only comparisons can be observed through the
+// comparator, assignments stay at 0.
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+void stdSort(IntSpan array, Metrics &metrics)
+{
+    sort(array.begin(), array.end(), [&metrics](int a, int b) {
+        return lessThan(a, b, metrics);
+    });
+}
+
+template <typename Metrics>
+void stdStableSort(IntSpan array, Metrics &metrics)
+{
+    stable_sort(array.begin(), array.end(), [&metrics](int a, int b) {
+        return lessThan(a, b, metrics);
+    });
+}
+
+template void insertionSortRange<SortMetrics>(IntSpan, int, int, SortMetrics&);
+template void insertionSortRange<NoMetrics>(IntSpan, int, int, NoMetrics&);
+template void heapSortRange<SortMetrics>(IntSpan, int, int, SortMetrics&);
+template void heapSortRange<NoMetrics>(IntSpan, int, int, NoMetrics&);
+template void mergeRuns<SortMetrics>(const int*, int*, int, int, int, SortMetrics&);
+template void mergeRuns<NoMetrics>(const int*, int*, int, int, int, NoMetrics&);
+INSTANTIATE_SORT_KERNEL(insertionSort)
+INSTANTIATE_SORT_KERNEL(introSort)
+INSTANTIATE_SORT_KERNEL(pdqSort)
+INSTANTIATE_SORT_KERNEL(mergeSortBottomUp)
+INSTANTIATE_SORT_KERNEL(timSort)
+INSTANTIATE_SORT_KERNEL(stdSort)
+INSTANTIATE_SORT_KERNEL(stdStableSort)
@@ -0,0 +1,296 @@
+//
+// Sort visualizer. A worker thread runs bubbleSort or HeapSort with the
+// event-streaming metrics policy; every frame the GL thread drains a bounded
+// number of compare/swap events from the ring, replays the swaps on its copy
+// of the bar heights, re-uploads them into an orphaned instance buffer and
+// draws all bars with a single instanced draw of cube.obj.
+//
+#include <jni.h>
+#include <android/log.h>
+#include <android/asset_manager.h>
+#include <GLES3/gl3.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <sstream>
+#include <algorithm>
+
+#include <../glm/glm.hpp>
+#include <../glm/gtc/matrix_transform.hpp>
+#include <../glm/gtc/type_ptr.hpp>
+
+#include "../includes/Shader.hpp"
+#include "../includes/tiny_obj_loader.h"
+#include "../includes/sortingAlg.hpp"
+#include "../includes/sortEventRing.hpp"
+#include "../includes/sortVisualizer.hpp"
+#include "../includes/dataGenerator.hpp"
+
+#define LOG_TAG "SortVisualizer"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#define CHECK_GL_ERROR(op) \
+    for (GLint error = glGetError(); error; error = glGetError()) { \
+        LOGE("after %s() glError (0x%x)", op, error); \
+    }
+
+using namespace std;
+
+static const char* BAR_MESH_PATH = "objects/cube/cube.obj";
+// 64K events of 8 bytes: 512 KB between the sort and the renderer
+static const int EVENT_RING_CAPACITY_LOG2 = 16;
+// Events replayed per frame. Bounds the CPU time a frame spends on the ring
+// and sets the animation speed; the sort blocks once the ring is full.
+static const int MAX_EVENTS_PER_FRAME = 1 << 15;
+static const int DRAIN_CHUNK = 4096;
+static const int MAX_BAR_COUNT = 1 << 20;
+
+struct SortVisualizer {
+    SortEventRing ring{EVENT_RING_CAPACITY_LOG2};
+    SortEventSignal spaceFreed;
+    atomic<bool> cancel{false};
+    thread worker;
+    vector<int> values;     // owned by the worker while it runs
+    int engineId = SORT_BUBBLE;
+
+    // GL thread state
+    bool active = false;
+    vector<float> heights;
+    vector<SortEvent> drained = vector<SortEvent>(DRAIN_CHUNK);
+    glm::ivec2 highlight = glm::ivec2(-1);
+    bool heightsDirty = false;
+
+    // GL objects, recreated with every context
+    gps::Shader shader;
+    GLuint vao = 0;
+    GLuint meshVbo = 0;
+    GLuint heightVbo = 0;
+    GLsizei meshVertexCount = 0;
+    bool glReady = false;
+
+    ~SortVisualizer() { stopWorker(); }
+
+    void stopWorker()
+    {
+        cancel.store(true);
+        spaceFreed.notify();
+        if (worker.joinable())
+            worker.join();
+    }
+};
+
+static SortVisualizer g_visualizer;
+
+static void runSortWorker(SortVisualizer* v)
+{
+    SortEventMetrics metrics(&v->ring, &v->spaceFreed, &v->cancel);
+    try
+    {
+        if (v->engineId == SORT_HEAP)
+            HeapSort<int>(v->values, metrics);
+        else
+            bubbleSort<int>(v->values, metrics);
+        LOGI("Sort finished, %zu elements", v->values.size());
+    }
+    catch (const SortCancelled&)
+    {
+        LOGI("Sort cancelled");
+    }
+}
+
+// Unindexed triangles, position then normal, 6 floats per vertex
+static vector<float> loadBarMesh(AAssetManager* assetManager)
+{
+    vector<float> vertices;
+    AAsset* asset = AAssetManager_open(assetManager, BAR_MESH_PATH, AASSET_MODE_BUFFER);
+    if (!asset)
+    {
+        LOGE("Could not open %s", BAR_MESH_PATH);
+        return vertices;
+    }
+    string text((const char*) AAsset_getBuffer(asset), AAsset_getLength(asset));
+    AAsset_close(asset);
+
+    // The material library is not needed, the shader colours the bars
+    istringstream stream(text);
+    tinyobj::attrib_t attrib;
+    vector<tinyobj::shape_t> shapes;
+    vector<tinyobj::material_t> materials;
+    string err;
+    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &stream))
+    {
+        LOGE("Could not parse %s: %s", BAR_MESH_PATH, err.c_str());
+        return vertices;
+    }
+
+    for (const tinyobj::shape_t& shape : shapes)
+    {
+        for (const tinyobj::index_t& idx : shape.mesh.indices)
+        {
+            for (int c = 0; c < 3; c++)
+                vertices.push_back(attrib.vertices[3 * idx.vertex_index + c]);
+            for (int c = 0; c < 3; c++)
+                vertices.push_back(idx.normal_index >= 0 ? attrib.normals[3 * idx.normal_index + c] : 0.0f);
+        }
+    }
+    return vertices;
+}
+
+void initSortVisualizer(AAssetManager* assetManager)
+{
+    SortVisualizer& v = g_visualizer;
+    v.glReady = false;
+
+    v.shader = gps::Shader();
+    v.shader.loadShader("shaders/sortBars.vert", "shaders/sortBars.frag", assetManager);
+    vector<float> mesh = loadBarMesh(assetManager);
+    if (v.shader.shaderProgram == 0 || mesh.empty())
+    {
+        LOGE("Sort visualizer unavailable");
+        return;
+    }
+    v.meshVertexCount = mesh.size() / 6;
+
+    glGenVertexArrays(1, &v.vao);
+    glGenBuffers(1, &v.meshVbo);
+    glGenBuffers(1, &v.heightVbo);
+    glBindVertexArray(v.vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, v.meshVbo);
+    glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(float), mesh.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*) (3 * sizeof(float)));
+
+    // One float per bar, advanced once per instance
+    glBindBuffer(GL_ARRAY_BUFFER, v.heightVbo);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*) 0);
+    glVertexAttribDivisor(2, 1);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    CHECK_GL_ERROR("sort visualizer buffers");
+
+    // The new buffer is empty, so the next frame uploads every height
+    v.heightsDirty = true;
+    v.glReady = true;
+    LOGI("Sort visualizer ready, %d vertices per bar", v.meshVertexCount);
+}
+
+bool sortVisualizerActive()
+{
+    return g_visualizer.active && !g_visualizer.cancel.load(memory_order_relaxed);
+}
+
+// Replays up to MAX_EVENTS_PER_FRAME queued steps on the heights
+static void drainSortEvents(SortVisualizer& v)
+{
+    int replayed = 0;
+    while (replayed < MAX_EVENTS_PER_FRAME)
+    {
+        int count = v.ring.popBulk(v.drained.data(), min(DRAIN_CHUNK, MAX_EVENTS_PER_FRAME - replayed));
+        if (count == 0)
+            break;
+        for (int k = 0; k < count; k++)
+        {
+            const SortEvent& event = v.drained[k];
+            if (event.type() == SORT_EVENT_SWAP)
+                swap(v.heights[event.i()], v.heights[event.j()]);
+        }
+        const SortEvent& last = v.drained[count - 1];
+        v.highlight = glm::ivec2(last.i(), last.j());
+        replayed += count;
+    }
+    if (replayed > 0)
+    {
+        v.heightsDirty = true;
+        v.spaceFreed.notify();
+    }
+    else
+        v.highlight = glm::ivec2(-1);
+}
+
+void drawSortVisualizer(int screenWidth, int screenHeight)
+{
+    SortVisualizer& v = g_visualizer;
+    glViewport(0, 0, screenWidth, screenHeight);
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    if (!v.glReady)
+        return;
+
+    drainSortEvents(v);
+
+    // Orphan the old storage so the driver can hand out fresh memory instead
+    // of waiting for the GPU to finish the previous frame's draw
+    if (v.heightsDirty)
+    {
+        GLsizeiptr bytes = v.heights.size() * sizeof(float);
+        glBindBuffer(GL_ARRAY_BUFFER, v.heightVbo);
+        glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, v.heights.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        v.heightsDirty = false;
+        CHECK_GL_ERROR("height upload");
+    }
+
+    GLuint program = v.shader.shaderProgram;
+    v.shader.useShaderProgram();
+    glm::mat4 projection = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f, -2.0f, 2.0f);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform1f(glGetUniformLocation(program, "barCount"), (float) v.heights.size());
+    glUniform2i(glGetUniformLocation(program, "highlight"), v.highlight.x, v.highlight.y);
+    glUniform3f(glGetUniformLocation(program, "lightDir"), 0.3f, 0.5f, 1.0f);
+
+    glBindVertexArray(v.vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, v.meshVertexCount, v.heights.size());
+    glBindVertexArray(0);
+    CHECK_GL_ERROR("glDrawArraysInstanced");
+}
+
+// ----------------------------------------------------------------------------
+// JNI, on MyGLRenderer
+// ----------------------------------------------------------------------------
+
+// GL thread. Starts animating engineId (SORT_BUBBLE or SORT_HEAP) on
+// elementCount uniform random values, replacing a running visualization
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myapplication_MyGLRenderer_nativeStartSortVisualization(JNIEnv*, jobject, jint engineId, jint elementCount)
+{
+    if (engineId != SORT_BUBBLE && engineId != SORT_HEAP)
+    {
+        LOGE("Engine %d does not emit sort events", engineId);
+        return;
+    }
+    SortVisualizer& v = g_visualizer;
+    v.stopWorker();
+    v.ring.reset();
+
+    int n = max(2, min((int) elementCount, MAX_BAR_COUNT));
+    v.values = generateInput(INPUT_UNIFORM, n);
+    int maxValue = *max_element(v.values.begin(), v.values.end());
+    v.heights.resize(n);
+    for (int i = 0; i < n; i++)
+        v.heights[i] = (float) v.values[i] / maxValue;
+    v.highlight = glm::ivec2(-1);
+    v.heightsDirty = true;
+
+    v.engineId = engineId;
+    v.cancel.store(false);
+    v.worker = thread(runSortWorker, &v);
+    v.active = true;
+    LOGI("Visualizing engine %d on %d elements", engineId, n);
+}
+
+// Any thread. The sort unwinds at its next full ring and the renderer goes
+// back to the model; the worker is joined by the next start.
+extern "C" JNIEXPORT void JNICALL
+Java_com_example_myapplication_MyGLRenderer_nativeStopSortVisualization(JNIEnv*, jobject)
+{
+    g_visualizer.cancel.store(true);
+    g_visualizer.spaceFreed.notify();
+}
@@ -5,19 +5,21 @@
 #include <string>
 #include <vector>
 #include <chrono>
-#include <sstream>
-#include <random>
 #include <algorithm>
+#include <android/log.h>
 
-using namespace std;
+#include "../includes/sortingAlg.hpp"
+#include "../includes/elementTraits.hpp"
+#include "../includes/dataGenerator.hpp"
+#include "../includes/sortEventRing.hpp"
 
-struct SortMetrics {
-    long assigments = 0;
-    long comparison = 0;
-    long long duration_ms = 0;
-};
+#define LOG_TAG "SortBenchmark"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
 
-void bubbleSort(vector<int>&array, SortMetrics &metrics)
+template <typename T, typename Metrics>
+void bubbleSort(Span<T> array, Metrics &metrics)
 {
     int n = array.size();
     bool swapped;
@@ -27,8 +29,10 @@ void bubbleSort(vector<int>&array, SortMetrics &metrics)
         for (int j=0; j<n-i-1; j++)
         {
             metrics.comparison++;
-            if (array[j] > array[j + 1]) {
+            metrics.onCompare(j + 1, j);
+            if (ElementTraits<T>::less(array[j + 1], array[j])) {
                 metrics.assigments += 3;
+                metrics.onSwap(j, j + 1);
                 swap(array[j], array[j + 1]);
                 swapped = true;
             }
@@ -38,7 +42,8 @@ void bubbleSort(vector<int>&array, SortMetrics &metrics)
     }
 }
 
-void maxHeapify (vector<int>&array, int n, int i, SortMetrics &metrics)
+template <typename T, typename Metrics>
+void maxHeapify (Span<T> array, int n, int i, Metrics &metrics)
 {
     int largest = i;
     int left = 2*i+1;
@@ -47,27 +52,31 @@ void maxHeapify (vector<int>&array, int n, int i, SortMetrics &metrics)
     if(left < n)
     {
         metrics.comparison++;
-        if(array[left] > array[largest])
+        metrics.onCompare(largest, left);
+        if(ElementTraits<T>::less(array[largest], array[left]))
             largest = left;
 
     }
     if(right <n)
     {
         metrics.comparison++;
-        if(array[right] > array[largest])
+        metrics.onCompare(largest, right);
+        if(ElementTraits<T>::less(array[largest], array[right]))
             largest = right;
 
     }
     if(largest!=i)
     {
         metrics.assigments += 3;
+        metrics.onSwap(i, largest);
         swap(array[i], array[largest]);
         maxHeapify(array, n, largest, metrics);
 
     }
 }
 
-void HeapSort(vector<int>&array, SortMetrics &metrics)
+template <typename T, typename Metrics>
+void HeapSort(Span<T> array, Metrics &metrics)
 {
     int n = array.size();
     for(int i=n/2-1; i>=0; i--)
@@ -75,50 +84,344 @@ void HeapSort(vector<int>&array, SortMetrics &metrics)
     for(int i = n-1; i>0; i--)
     {
         metrics.assigments +=3;
+        metrics.onSwap(0, i);
         swap(array[0], array[i]);
         maxHeapify(array, i, 0, metrics);
     }
 }
 
-extern "C" JNIEXPORT jstring JNICALL
-Java_com_example_myapplication_testCpuWithSorting_runAdvanceSort(JNIEnv *env, jobject, jint arraySize)
+INSTANTIATE_ELEMENT_KERNEL(bubbleSort)
+INSTANTIATE_ELEMENT_KERNEL(HeapSort)
+template void maxHeapify<int, SortMetrics>(IntSpan, int, int, SortMetrics&);
+template void maxHeapify<int, NoMetrics>(IntSpan, int, int, NoMetrics&);
+// Event-streaming instances for the sort visualizer
+template void bubbleSort<int, SortEventMetrics>(IntSpan, SortEventMetrics&);
+template void HeapSort<int, SortEventMetrics>(IntSpan, SortEventMetrics&);
+
+// The last column is the engine's scratch beyond the array: merge buffers,
+// radix ping-pong arrays, the MSD sort's int64 widening, the B-heap's padded
+// copy (up to twice n when the last level is short)
+static const vector<SortEngine> sortEngines = {
+        {SORT_BUBBLE,          "Bubble Sort",          bubbleSort<int, SortMetrics>, bubbleSort<int, NoMetrics>, 0},
+        {SORT_HEAP,            "Heap Sort",            HeapSort<int, SortMetrics>, HeapSort<int, NoMetrics>, 0},
+        {SORT_INTRO,           "Introsort",            introSort<SortMetrics>, introSort<NoMetrics>, 0},
+        {SORT_PDQ,             "Pdqsort",              pdqSort<SortMetrics>, pdqSort<NoMetrics>, 0},
+        {SORT_MERGE_BOTTOM_UP, "Merge Sort Bottom-Up", mergeSortBottomUp<SortMetrics>, mergeSortBottomUp<NoMetrics>, 1},
+        {SORT_TIM,             "Timsort",              timSort<SortMetrics>, timSort<NoMetrics>, 1},
+        {SORT_STD,             "std::sort",            stdSort<SortMetrics>, stdSort<NoMetrics>, 0},
+        {SORT_STD_STABLE,      "std::stable_sort",     stdStableSort<SortMetrics>, stdStableSort<NoMetrics>, 1},
+        {SORT_HEAP_FLOYD,      "Heap Sort Floyd",      floydHeapSort<SortMetrics>, floydHeapSort<NoMetrics>, 0},
+        {SORT_HEAP_4ARY,       "Heap Sort 4-ary",      heapSort4ary<SortMetrics>, heapSort4ary<NoMetrics>, 0},
+        {SORT_HEAP_8ARY,       "Heap Sort 8-ary",      heapSort8ary<SortMetrics>, heapSort8ary<NoMetrics>, 0},
+        {SORT_HEAP_BLOCKED,    "Heap Sort B-heap",     blockedHeapSort<SortMetrics>, blockedHeapSort<NoMetrics>, 3},
+        {SORT_PARALLEL_SAMPLE, "Parallel Sample Sort", parallelSampleSortAllCores<SortMetrics>, parallelSampleSortAllCores<NoMetrics>, 1},
+        {SORT_PARALLEL_MERGE,  "Parallel Merge Sort",  parallelMergeSortAllCores<SortMetrics>, parallelMergeSortAllCores<NoMetrics>, 1},
+        {SORT_QUICK_NETWORK_LEAVES, "Quicksort Network Leaves", quickSortNetworkLeaves<SortMetrics>, quickSortNetworkLeaves<NoMetrics>, 0},
+        {SORT_MERGE_SIMD,      "Merge Sort SIMD",      mergeSortSimd<SortMetrics>, mergeSortSimd<NoMetrics>, 2},
+        {SORT_LSD_RADIX_8,     "LSD Radix 8-bit",      lsdRadixSort8<SortMetrics>, lsdRadixSort8<NoMetrics>, 1},
+        {SORT_LSD_RADIX_11,    "LSD Radix 11-bit",     lsdRadixSort11<SortMetrics>, lsdRadixSort11<NoMetrics>, 1},
+        {SORT_MSD_RADIX_64,    "MSD Radix 64-bit",     msdRadixSortHybrid<SortMetrics>, msdRadixSortHybrid<NoMetrics>, 4},
+        {SORT_BUBBLE_BRANCHLESS, "Bubble Sort Branchless", bubbleSortBranchless<SortMetrics>, bubbleSortBranchless<NoMetrics>, 0},
+        {SORT_HEAP_BRANCHLESS, "Heap Sort Branchless", heapSortBranchless<SortMetrics>, heapSortBranchless<NoMetrics>, 0},
+        {SORT_BLOCK_QUICK,     "BlockQuicksort",       blockQuickSort<SortMetrics>, blockQuickSort<NoMetrics>, 0},
+        {SORT_INSERTION,       "Insertion Sort",       insertionSort<SortMetrics>, insertionSort<NoMetrics>, 0},
+        {SORT_QUICK_BRANCHY,   "Quicksort Branchy",    quickSortBranchy<SortMetrics>, quickSortBranchy<NoMetrics>, 0},
+};
+
+const vector<SortEngine>& getSortEngines()
+{
+    return sortEngines;
+}
+
+void releaseSortScratch()
 {
-    vector<int> original_data(arraySize);
-    mt19937 gen(12345);
-    uniform_int_distribution<int> dis(1, 1000000);
-    for(int i=0; i< arraySize; i++)
+    releaseMergeScratch();
+    releaseBlockedHeapScratch();
+    releaseSimdMergeScratch();
+    releaseRadixScratch();
+}
+
+const SortEngine* findSortEngine(int id)
+{
+    for (const SortEngine &engine : sortEngines)
     {
-        original_data[i] = dis(gen);
+        if (engine.id == id)
+            return &engine;
     }
+    return nullptr;
+}
+
+vector<int> generateSortInput(int arraySize)
+{
+    return generateInput(INPUT_UNIFORM, arraySize);
+}
 
-    //bubleSort
-    vector<int> data_buble = original_data;
-    SortMetrics metrics_buble;
+SortMetrics runSortEngine(const SortEngine &engine, IntSpan array)
+{
+    SortMetrics metrics;
 
+    // Counting pass on a copy, so both passes see the same input
+    vector<int> counted(array.begin(), array.end());
     auto start = chrono::high_resolution_clock::now();
-    bubbleSort(data_buble, metrics_buble);
+    engine.sort(counted, metrics);
     auto end = chrono::high_resolution_clock::now();
+    metrics.counted_duration_ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
 
-    metrics_buble.duration_ms = chrono::duration_cast<chrono::milliseconds>(end - start).count();
-
-    //heapSort
-    vector<int> data_heap = original_data;
-    SortMetrics metrics_heap;
-
+    NoMetrics timed;
     start = chrono::high_resolution_clock::now();
-    HeapSort(data_heap, metrics_heap);
+    engine.sortTimed(array, timed);
     end = chrono::high_resolution_clock::now();
+    metrics.duration_ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+
+    if (!equal(array.begin(), array.end(), counted.begin()))
+        LOGE("%s: counting and timing passes disagree", engine.name);
+    return metrics;
+}
+
+void appendSortRecord(const SortEngine &engine, const vector<int> &input, int iterations, vector<int64_t> &out)
+{
+    size_t header = out.size();
+    out.resize(header + RECORD_HEADER_SIZE + iterations, 0);
+    out[header + RECORD_ENGINE_ID] = engine.id;
+    out[header + RECORD_ARRAY_SIZE] = input.size();
+    out[header + RECORD_ITERATIONS] = iterations;
+
+    for (int it = 0; it < iterations; it++)
+    {
+        vector<int> data = input;
+        if (it == 0)
+        {
+            SortMetrics metrics = runSortEngine(engine, data);
+            out[header + RECORD_COMPARISONS] = metrics.comparison;
+            out[header + RECORD_ASSIGNMENTS] = metrics.assigments;
+            out[header + RECORD_COUNTED_NS] = metrics.counted_duration_ns;
+            out[header + RECORD_SAMPLES] = metrics.duration_ns;
+            if (!is_sorted(data.begin(), data.end()))
+                LOGE("%s produced unsorted output", engine.name);
+            continue;
+        }
+
+        NoMetrics timed;
+        auto start = chrono::high_resolution_clock::now();
+        engine.sortTimed(data, timed);
+        auto end = chrono::high_resolution_clock::now();
+        out[header + RECORD_SAMPLES + it] = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    }
+}
+
+static jlongArray toJavaLongArray(JNIEnv *env, const vector<int64_t> &values)
+{
+    jlongArray result = env->NewLongArray(values.size());
+    env->SetLongArrayRegion(result, 0, values.size(), (const jlong *) values.data());
+    return result;
+}
+
+// Bubble sort record followed by heap sort record, both on the same input
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runAdvanceSort(JNIEnv *env, jobject, jint arraySize, jint iterations)
+{
+    vector<int> original_data = generateSortInput(arraySize);
+
+    vector<int64_t> records;
+    appendSortRecord(*findSortEngine(SORT_BUBBLE), original_data, iterations, records);
+    appendSortRecord(*findSortEngine(SORT_HEAP), original_data, iterations, records);
+
+    return toJavaLongArray(env, records);
+}
+
+// Runs a single engine from the registry, one record in the runAdvanceSort layout
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runSortEngine(JNIEnv *env, jobject, jint engineId, jint arraySize, jint iterations)
+{
+    const SortEngine *engine = findSortEngine(engineId);
+    if (engine == nullptr || iterations < 1)
+    {
+        LOGE("Unknown sort engine id %d or no iterations", engineId);
+        return NULL;
+    }
+
+    vector<int64_t> record;
+    appendSortRecord(*engine, generateSortInput(arraySize), iterations, record);
+    return toJavaLongArray(env, record);
+}
 
-    metrics_heap.duration_ms = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+// Same record as runSortEngine, on one of the InputDistribution inputs
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runSortEngineOnInput(JNIEnv *env, jobject, jint engineId, jint arraySize,
+                                                                      jint distribution, jint parameter, jint iterations)
+{
+    const SortEngine *engine = findSortEngine(engineId);
+    if (engine == nullptr || iterations < 1 || getInputDistributionName(distribution) == nullptr)
+    {
+        LOGE("Bad engine %d, distribution %d or iteration count", engineId, distribution);
+        return NULL;
+    }
+
+    vector<int64_t> record;
+    appendSortRecord(*engine, generateInput(distribution, arraySize, parameter), iterations, record);
+    return toJavaLongArray(env, record);
+}
+
+// Engine names indexed by id
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_getSortEngineNames(JNIEnv *env, jobject)
+{
+    jclass stringClass = env->FindClass("java/lang/String");
+    jobjectArray names = env->NewObjectArray(sortEngines.size(), stringClass, NULL);
+    for (const SortEngine &engine : sortEngines)
+    {
+        jstring name = env->NewStringUTF(engine.name);
+        env->SetObjectArrayElement(names, engine.id, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+static jlong elapsedNs(chrono::high_resolution_clock::time_point start, chrono::high_resolution_clock::time_point end)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+}
+
+// Sorts a caller-owned IntArray in place. The array is pinned with
+// GetPrimitiveArrayCritical, so the GC is held off for the timed sort; if the
+// VM hands out a copy anyway, the copy cost lands in pin and release time.
+// Returns [pin ns, sort ns, release ns, isCopy, operations].
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_sortIntArrayInPlace(JNIEnv *env, jobject, jint engineId, jintArray data)
+{
+    const SortEngine *engine = findSortEngine(engineId);
+    if (engine == nullptr || data == NULL)
+    {
+        LOGE("sortIntArrayInPlace: unknown engine %d or null array", engineId);
+        return NULL;
+    }
+    jsize length = env->GetArrayLength(data);
+
+    // Counts come from a scratch copy sorted before pinning, so the GC is only
+    // held off for the uninstrumented pass over the caller's data
+    SortMetrics metrics;
+    vector<int> counted(length);
+    env->GetIntArrayRegion(data, 0, length, counted.data());
+    engine->sort(counted, metrics);
+
+    jboolean isCopy = JNI_FALSE;
+    auto pinStart = chrono::high_resolution_clock::now();
+    jint *elements = (jint *) env->GetPrimitiveArrayCritical(data, &isCopy);
+    auto pinEnd = chrono::high_resolution_clock::now();
+    if (elements == NULL)
+    {
+        LOGE("sortIntArrayInPlace: could not pin the array");
+        return NULL;
+    }
+
+    // No JNI calls allowed until the array is released
+    NoMetrics timed;
+    auto sortStart = chrono::high_resolution_clock::now();
+    engine->sortTimed(IntSpan(elements, length), timed);
+    auto sortEnd = chrono::high_resolution_clock::now();
+
+    env->ReleasePrimitiveArrayCritical(data, elements, 0);
+    auto releaseEnd = chrono::high_resolution_clock::now();
 
-    long bubble_ops = metrics_buble.assigments + metrics_buble.comparison;
-    long heap_ops = metrics_heap.assigments + metrics_heap.comparison;
+    jlong report[5] = {
+            elapsedNs(pinStart, pinEnd),
+            elapsedNs(sortStart, sortEnd),
+            elapsedNs(sortEnd, releaseEnd),
+            isCopy ? 1 : 0,
+            metrics.assigments + metrics.comparison
+    };
+    jlongArray result = env->NewLongArray(5);
+    env->SetLongArrayRegion(result, 0, 5, report);
+    return result;
+}
+
+// Sorts the ints of a direct ByteBuffer (native byte order) where they are,
+// nothing is pinned or copied. Same report layout as sortIntArrayInPlace,
+// the pin slot holds the GetDirectBufferAddress lookup.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_sortDirectBuffer(JNIEnv *env, jobject, jint engineId, jobject buffer)
+{
+    const SortEngine *engine = findSortEngine(engineId);
+    if (engine == nullptr)
+    {
+        LOGE("sortDirectBuffer: unknown engine %d", engineId);
+        return NULL;
+    }
+
+    auto pinStart = chrono::high_resolution_clock::now();
+    void *address = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    auto pinEnd = chrono::high_resolution_clock::now();
+    if (address == NULL || capacity < 0 || ((uintptr_t) address % sizeof(jint)) != 0)
+    {
+        LOGE("sortDirectBuffer: buffer is not a 4-byte aligned direct buffer");
+        return NULL;
+    }
+
+    IntSpan array((int *) address, (int) (capacity / sizeof(jint)));
+    SortMetrics metrics;
+    vector<int> counted(array.begin(), array.end());
+    engine->sort(counted, metrics);
 
-    std::stringstream result_ss;
-    result_ss << metrics_buble.duration_ms << "," << bubble_ops << ";";
-    result_ss << metrics_heap.duration_ms << "," << heap_ops;
+    NoMetrics timed;
+    auto sortStart = chrono::high_resolution_clock::now();
+    engine->sortTimed(array, timed);
+    auto sortEnd = chrono::high_resolution_clock::now();
 
-    return env->NewStringUTF(result_ss.str().c_str());
+    jlong report[5] = {
+            elapsedNs(pinStart, pinEnd),
+            elapsedNs(sortStart, sortEnd),
+            0,
+            0,
+            metrics.assigments + metrics.comparison
+    };
+    jlongArray result = env->NewLongArray(5);
+    env->SetLongArrayRegion(result, 0, 5, report);
+    return result;
 }
 
+// Parallel engine against single-threaded HeapSort on the same input.
+// Returns [threads, heap ms, parallel ms, speedup, thread 0 ms, thread 1 ms, ...]
+extern "C" JNIEXPORT jdoubleArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runParallelSort(JNIEnv *env, jobject, jint engineId, jint arraySize)
+{
+    if (engineId != SORT_PARALLEL_SAMPLE && engineId != SORT_PARALLEL_MERGE)
+    {
+        LOGE("Sort engine %d is not a parallel engine", engineId);
+        return NULL;
+    }
 
+    vector<int> original_data = generateSortInput(arraySize);
+
+    vector<int> data_heap = original_data;
+    NoMetrics metrics_heap;
+    auto start = chrono::high_resolution_clock::now();
+    HeapSort<int>(data_heap, metrics_heap);
+    auto end = chrono::high_resolution_clock::now();
+    double heap_ms = chrono::duration<double, milli>(end - start).count();
+
+    vector<int> data_parallel = original_data;
+    NoMetrics metrics_parallel;
+    vector<double> threadTimesMs;
+    start = chrono::high_resolution_clock::now();
+    if (engineId == SORT_PARALLEL_SAMPLE)
+        parallelSampleSort(data_parallel, getOnlineCoreCount(), metrics_parallel, threadTimesMs);
+    else
+        parallelMergeSort(data_parallel, getOnlineCoreCount(), metrics_parallel, threadTimesMs);
+    end = chrono::high_resolution_clock::now();
+    double parallel_ms = chrono::duration<double, milli>(end - start).count();
+
+    if (data_parallel != data_heap)
+        LOGE("Parallel engine %d disagrees with HeapSort", engineId);
+
+    vector<jdouble> report;
+    report.push_back(threadTimesMs.size());
+    report.push_back(heap_ms);
+    report.push_back(parallel_ms);
+    report.push_back(parallel_ms > 0 ? heap_ms / parallel_ms : 0.0);
+    report.insert(report.end(), threadTimesMs.begin(), threadTimesMs.end());
+
+    jdoubleArray result = env->NewDoubleArray(report.size());
+    env->SetDoubleArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
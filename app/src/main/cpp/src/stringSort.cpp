@@ -0,0 +1,335 @@
+//
+// String keys. The baseline sorts std::string objects; the other methods
+// keep every byte in one arena and sort 16-byte (offset, length, prefix)
+// handles whose first 8 key bytes travel with the handle. A comparison only
+// follows the offset into the arena when the prefixes tie, so with distinct
+// prefixes the whole sort stays in the handle array.
+//
+#include <jni.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/sortingAlg.hpp"
+#include "../includes/dataGenerator.hpp"
+
+#define LOG_TAG "StringSort"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+static const int PREFIX_BYTES = 8;
+static const int STRING_INSERTION_THRESHOLD = 16;
+static const int MIN_SUFFIX_LENGTH = 4;
+static const int MAX_SUFFIX_LENGTH = 24;
+
+// Ids are shared with Kotlin, append only
+enum StringSortMethod {
+    STRING_STD_SORT = 0,         // std::sort on std::string
+    STRING_HANDLES_NO_PREFIX,    // std::sort on handles, every comparison reads the arena
+    STRING_HANDLES_PREFIX,       // std::sort on handles, prefix first
+    STRING_MULTIKEY_QUICKSORT,   // Bentley-Sedgewick on handles
+    STRING_MSD_RADIX,            // byte-wise MSD radix on handles
+    STRING_METHOD_COUNT
+};
+
+// The prefix holds the first 8 bytes big-endian, zero padded, so comparing
+// prefixes as integers compares those bytes lexicographically
+struct StringHandle {
+    uint32_t offset;
+    uint32_t length;
+    uint64_t prefix;
+};
+
+struct StringArena {
+    vector<char> bytes;
+    vector<StringHandle> handles;
+
+    void add(const string &s)
+    {
+        uint64_t prefix = 0;
+        for (int i = 0; i < PREFIX_BYTES; i++)
+            prefix = (prefix << 8) | (i < (int) s.size() ? (unsigned char) s[i] : 0);
+        handles.push_back({(uint32_t) bytes.size(), (uint32_t) s.size(), prefix});
+        bytes.insert(bytes.end(), s.begin(), s.end());
+    }
+
+    string get(const StringHandle &h) const
+    {
+        return string(bytes.data() + h.offset, h.length);
+    }
+};
+
+// Byte `depth` of the key, -1 past its end
+static inline int charAt(const StringHandle &h, int depth, const char *arena)
+{
+    if (depth >= (int) h.length)
+        return -1;
+    if (depth < PREFIX_BYTES)
+        return (int) ((h.prefix >> (8 * (PREFIX_BYTES - 1 - depth))) & 0xFF);
+    return (unsigned char) arena[h.offset + depth];
+}
+
+// Compares the bytes from `depth` on, which the caller knows are equal before it
+static inline int compareFrom(const StringHandle &a, const StringHandle &b, int depth, const char *arena)
+{
+    int common = min(a.length, b.length);
+    if (depth < common)
+    {
+        int c = memcmp(arena + a.offset + depth, arena + b.offset + depth, common - depth);
+        if (c != 0)
+            return c;
+    }
+    return (int) a.length - (int) b.length;
+}
+
+static inline bool handleLess(const StringHandle &a, const StringHandle &b, const char *arena)
+{
+    if (a.prefix != b.prefix)
+        return a.prefix < b.prefix;
+    return compareFrom(a, b, min<int>(PREFIX_BYTES, min(a.length, b.length)), arena) < 0;
+}
+
+static inline bool handleLessNoPrefix(const StringHandle &a, const StringHandle &b, const char *arena)
+{
+    return compareFrom(a, b, 0, arena) < 0;
+}
+
+template <typename Metrics>
+static void insertionSortHandles(StringHandle *a, int n, const char *arena, Metrics &metrics)
+{
+    for (int i = 1; i < n; i++)
+    {
+        StringHandle key = a[i];
+        int j = i - 1;
+        while (j >= 0)
+        {
+            metrics.comparison++;
+            if (!handleLess(key, a[j], arena))
+                break;
+            a[j + 1] = a[j];
+            metrics.assigments++;
+            j--;
+        }
+        a[j + 1] = key;
+        metrics.assigments += 2;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Multikey quicksort (Bentley & Sedgewick): three-way partition on the byte
+// at `depth`; the equal part moves on to depth + 1, so no byte of a common
+// prefix is compared twice
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+static void multikeyQuickSort(StringHandle *a, int n, int depth, const char *arena, Metrics &metrics)
+{
+    while (n > STRING_INSERTION_THRESHOLD)
+    {
+        int pivot = charAt(a[n / 2], depth, arena);
+        int lt = 0, i = 0, gt = n - 1;
+        while (i <= gt)
+        {
+            int c = charAt(a[i], depth, arena);
+            metrics.comparison++;
+            if (c < pivot)
+            {
+                swap(a[lt++], a[i++]);
+                metrics.assigments += 3;
+            }
+            else if (c > pivot)
+            {
+                swap(a[i], a[gt--]);
+                metrics.assigments += 3;
+            }
+            else
+                i++;
+        }
+
+        multikeyQuickSort(a, lt, depth, arena, metrics);
+        multikeyQuickSort(a + gt + 1, n - gt - 1, depth, arena, metrics);
+        // Keys that ended at this depth are all equal
+        if (pivot < 0)
+            return;
+        a += lt;
+        n = gt - lt + 1;
+        depth++;
+    }
+    insertionSortHandles(a, n, arena, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// MSD radix sort, one byte per level with bucket 0 for keys that already
+// ended. A level where every key has the same byte only bumps the depth.
+// ----------------------------------------------------------------------------
+
+template <typename Metrics>
+static void msdRadixSortStrings(StringHandle *a, StringHandle *buffer, int n, int depth,
+                                const char *arena, Metrics &metrics)
+{
+    while (n > STRING_INSERTION_THRESHOLD)
+    {
+        int count[257] = {0};
+        for (int i = 0; i < n; i++)
+            count[charAt(a[i], depth, arena) + 1]++;
+        metrics.comparison += n;
+
+        int first = charAt(a[0], depth, arena) + 1;
+        if (count[first] == n)
+        {
+            if (first == 0)
+                return;
+            depth++;
+            continue;
+        }
+
+        int start[257];
+        int offset = 0;
+        for (int b = 0; b < 257; b++)
+        {
+            start[b] = offset;
+            offset += count[b];
+        }
+        int next[257];
+        copy(start, start + 257, next);
+        for (int i = 0; i < n; i++)
+            buffer[next[charAt(a[i], depth, arena) + 1]++] = a[i];
+        copy(buffer, buffer + n, a);
+        metrics.assigments += 2 * n;
+
+        for (int b = 1; b < 257; b++)
+        {
+            if (count[b] > 1)
+                msdRadixSortStrings(a + start[b], buffer + start[b], count[b], depth + 1, arena, metrics);
+        }
+        return;
+    }
+    insertionSortHandles(a, n, arena, metrics);
+}
+
+// ----------------------------------------------------------------------------
+// Benchmark
+// ----------------------------------------------------------------------------
+
+// sharedPrefix copies of 'a' followed by a random lowercase suffix; with
+// sharedPrefix >= 8 the handle prefixes never decide a comparison
+static vector<string> makeStrings(int count, int sharedPrefix)
+{
+    vector<string> strings(count);
+    Xoshiro256 rng(12345);
+    for (string &s : strings)
+    {
+        int length = rng.nextInRange(MIN_SUFFIX_LENGTH, MAX_SUFFIX_LENGTH);
+        s.assign(sharedPrefix, 'a');
+        for (int i = 0; i < length; i++)
+            s.push_back((char) rng.nextInRange('a', 'z'));
+    }
+    return strings;
+}
+
+template <typename Metrics>
+static void sortStrings(int method, vector<string> &strings, StringArena &arena, Metrics &metrics)
+{
+    const char *bytes = arena.bytes.data();
+    vector<StringHandle> &handles = arena.handles;
+    switch (method)
+    {
+        case STRING_STD_SORT:
+            sort(strings.begin(), strings.end(), [&metrics](const string &a, const string &b) {
+                metrics.comparison++;
+                return a < b;
+            });
+            break;
+        case STRING_HANDLES_NO_PREFIX:
+            sort(handles.begin(), handles.end(), [&metrics, bytes](const StringHandle &a, const StringHandle &b) {
+                metrics.comparison++;
+                return handleLessNoPrefix(a, b, bytes);
+            });
+            break;
+        case STRING_HANDLES_PREFIX:
+            sort(handles.begin(), handles.end(), [&metrics, bytes](const StringHandle &a, const StringHandle &b) {
+                metrics.comparison++;
+                return handleLess(a, b, bytes);
+            });
+            break;
+        case STRING_MULTIKEY_QUICKSORT:
+            multikeyQuickSort(handles.data(), handles.size(), 0, bytes, metrics);
+            break;
+        case STRING_MSD_RADIX:
+        {
+            vector<StringHandle> buffer(handles.size());
+            msdRadixSortStrings(handles.data(), buffer.data(), handles.size(), 0, bytes, metrics);
+            break;
+        }
+    }
+}
+
+static bool matchesExpected(int method, const vector<string> &strings, const StringArena &arena,
+                            const vector<string> &expected)
+{
+    if (method == STRING_STD_SORT)
+        return strings == expected;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        if (arena.get(arena.handles[i]) != expected[i])
+            return false;
+    }
+    return true;
+}
+
+// Sorts stringCount random strings that all start with sharedPrefix 'a's.
+// Returns [string count, arena bytes, permille of adjacent sorted keys told
+// apart by their 8-byte prefixes], then rows of [method, ns, comparisons,
+// assignments]; ns is the uninstrumented pass. Comparisons are key
+// comparisons for the std::sort methods and byte inspections for the others.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runStringSortBenchmark(JNIEnv *env, jobject, jint stringCount, jint sharedPrefix)
+{
+    vector<string> input = makeStrings(max(0, (int) stringCount), max(0, (int) sharedPrefix));
+    StringArena arena;
+    for (const string &s : input)
+        arena.add(s);
+
+    vector<string> expected = input;
+    sort(expected.begin(), expected.end());
+    long distinctPrefixes = 0;
+    for (size_t i = 1; i < expected.size(); i++)
+        distinctPrefixes += expected[i].compare(0, PREFIX_BYTES, expected[i - 1], 0, PREFIX_BYTES) != 0;
+
+    vector<jlong> report;
+    report.push_back(input.size());
+    report.push_back(arena.bytes.size());
+    report.push_back(input.size() > 1 ? distinctPrefixes * 1000 / (long) (input.size() - 1) : 0);
+
+    for (int method = 0; method < STRING_METHOD_COUNT; method++)
+    {
+        vector<string> countedStrings = input;
+        StringArena countedArena = arena;
+        SortMetrics metrics;
+        sortStrings(method, countedStrings, countedArena, metrics);
+
+        vector<string> strings = input;
+        StringArena timedArena = arena;
+        NoMetrics timed;
+        auto start = chrono::high_resolution_clock::now();
+        sortStrings(method, strings, timedArena, timed);
+        auto end = chrono::high_resolution_clock::now();
+
+        if (!matchesExpected(method, strings, timedArena, expected) ||
+            !matchesExpected(method, countedStrings, countedArena, expected))
+            LOGE("String sort method %d disagrees with std::sort", method);
+
+        report.push_back(method);
+        report.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        report.push_back(metrics.comparison);
+        report.push_back(metrics.assigments);
+    }
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
@@ -0,0 +1,221 @@
+//
+// Top-k selection: the k smallest elements in order without sorting the
+// rest. nth_element and partial_sort_copy are the library baselines, the
+// bounded heap keeps k candidates in a max-heap maintained by maxHeapify,
+// and the parallel variant runs one bounded heap per thread and merges the
+// per-thread candidates with one more.
+//
+#include <jni.h>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/sortingAlg.hpp"
+
+#define LOG_TAG "TopKSelect"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+// Below this many elements per thread a thread costs more than its scan saves
+static const int PARALLEL_TOPK_MIN_PER_THREAD = 1 << 14;
+
+// Ids are shared with Kotlin, append only
+enum TopKMethod {
+    TOPK_FULL_HEAP_SORT = 0,   // HeapSort the whole array, keep the first k
+    TOPK_FULL_STD_SORT,        // std::sort the whole array, keep the first k
+    TOPK_NTH_ELEMENT,
+    TOPK_PARTIAL_SORT,
+    TOPK_BOUNDED_HEAP,
+    TOPK_PARALLEL,
+    TOPK_METHOD_COUNT
+};
+
+template <typename Metrics>
+void topKNthElement(IntSpan array, int k, vector<int> &out, Metrics &metrics)
+{
+    k = max(0, min(k, array.size()));
+    auto less = [&metrics](int a, int b) { return lessThan(a, b, metrics); };
+
+    vector<int> work(array.begin(), array.end());
+    metrics.assigments += array.size();
+    if (k < array.size())
+        nth_element(work.begin(), work.begin() + k, work.end(), less);
+    sort(work.begin(), work.begin() + k, less);
+    out.assign(work.begin(), work.begin() + k);
+    metrics.assigments += k;
+}
+
+template <typename Metrics>
+void topKPartialSort(IntSpan array, int k, vector<int> &out, Metrics &metrics)
+{
+    k = max(0, min(k, array.size()));
+    out.resize(k);
+    partial_sort_copy(array.begin(), array.end(), out.begin(), out.end(),
+                      [&metrics](int a, int b) { return lessThan(a, b, metrics); });
+}
+
+// out holds the k smallest seen so far as a max-heap: an element only gets
+// in when it beats the root, which for random input happens O(k log(n / k))
+// times, so most of the scan is one comparison per element
+template <typename Metrics>
+void topKBoundedHeap(IntSpan array, int k, vector<int> &out, Metrics &metrics)
+{
+    int n = array.size();
+    k = max(0, min(k, n));
+    out.assign(array.begin(), array.begin() + k);
+    metrics.assigments += k;
+    if (k == 0)
+        return;
+
+    IntSpan heap(out);
+    for (int i = k / 2 - 1; i >= 0; i--)
+        maxHeapify(heap, k, i, metrics);
+
+    for (int i = k; i < n; i++)
+    {
+        if (lessThan(array[i], heap[0], metrics))
+        {
+            heap[0] = array[i];
+            metrics.assigments++;
+            maxHeapify(heap, k, 0, metrics);
+        }
+    }
+
+    // Heap sort the candidates into ascending order
+    for (int i = k - 1; i > 0; i--)
+    {
+        swapCounted(heap[0], heap[i], metrics);
+        maxHeapify(heap, i, 0, metrics);
+    }
+}
+
+template <typename Metrics>
+void topKParallel(IntSpan array, int k, int threadCount, vector<int> &out, Metrics &metrics)
+{
+    int n = array.size();
+    int p = max(1, min(threadCount, n / PARALLEL_TOPK_MIN_PER_THREAD));
+    if (p == 1)
+    {
+        topKBoundedHeap(array, k, out, metrics);
+        return;
+    }
+
+    vector<vector<int>> candidates(p);
+    vector<Metrics> threadMetrics(p);
+    auto work = [&](int t) {
+        int lo = (int) ((long long) n * t / p);
+        int hi = (int) ((long long) n * (t + 1) / p);
+        topKBoundedHeap(IntSpan(array.data() + lo, hi - lo), k, candidates[t], threadMetrics[t]);
+    };
+
+    vector<thread> workers;
+    for (int t = 1; t < p; t++)
+        workers.emplace_back(work, t);
+    work(0);
+    for (thread &worker : workers)
+        worker.join();
+
+    vector<int> merged;
+    for (int t = 0; t < p; t++)
+    {
+        merged.insert(merged.end(), candidates[t].begin(), candidates[t].end());
+        metrics.comparison += threadMetrics[t].comparison;
+        metrics.assigments += threadMetrics[t].assigments;
+        metrics.assigments += candidates[t].size();
+    }
+    topKBoundedHeap(IntSpan(merged), k, out, metrics);
+}
+
+template <typename Metrics>
+static void topKFullHeapSort(IntSpan array, int k, vector<int> &out, Metrics &metrics)
+{
+    k = max(0, min(k, array.size()));
+    vector<int> work(array.begin(), array.end());
+    metrics.assigments += array.size();
+    HeapSort<int>(work, metrics);
+    out.assign(work.begin(), work.begin() + k);
+    metrics.assigments += k;
+}
+
+template <typename Metrics>
+static void topKFullStdSort(IntSpan array, int k, vector<int> &out, Metrics &metrics)
+{
+    k = max(0, min(k, array.size()));
+    vector<int> work(array.begin(), array.end());
+    metrics.assigments += array.size();
+    stdSort(IntSpan(work), metrics);
+    out.assign(work.begin(), work.begin() + k);
+    metrics.assigments += k;
+}
+
+template <typename Metrics>
+static void topKParallelAllCores(IntSpan array, int k, vector<int> &out, Metrics &metrics)
+{
+    topKParallel(array, k, getOnlineCoreCount(), out, metrics);
+}
+
+#define INSTANTIATE_TOPK_KERNEL(kernel) \
+    template void kernel<SortMetrics>(IntSpan, int, vector<int>&, SortMetrics&); \
+    template void kernel<NoMetrics>(IntSpan, int, vector<int>&, NoMetrics&);
+
+INSTANTIATE_TOPK_KERNEL(topKNthElement)
+INSTANTIATE_TOPK_KERNEL(topKPartialSort)
+INSTANTIATE_TOPK_KERNEL(topKBoundedHeap)
+template void topKParallel<SortMetrics>(IntSpan, int, int, vector<int>&, SortMetrics&);
+template void topKParallel<NoMetrics>(IntSpan, int, int, vector<int>&, NoMetrics&);
+
+struct TopKEngine {
+    int method;
+    void (*select)(IntSpan, int, vector<int>&, SortMetrics&);
+    void (*selectTimed)(IntSpan, int, vector<int>&, NoMetrics&);
+};
+
+static const TopKEngine topKEngines[TOPK_METHOD_COUNT] = {
+        {TOPK_FULL_HEAP_SORT, topKFullHeapSort<SortMetrics>, topKFullHeapSort<NoMetrics>},
+        {TOPK_FULL_STD_SORT,  topKFullStdSort<SortMetrics>, topKFullStdSort<NoMetrics>},
+        {TOPK_NTH_ELEMENT,    topKNthElement<SortMetrics>, topKNthElement<NoMetrics>},
+        {TOPK_PARTIAL_SORT,   topKPartialSort<SortMetrics>, topKPartialSort<NoMetrics>},
+        {TOPK_BOUNDED_HEAP,   topKBoundedHeap<SortMetrics>, topKBoundedHeap<NoMetrics>},
+        {TOPK_PARALLEL,       topKParallelAllCores<SortMetrics>, topKParallelAllCores<NoMetrics>},
+};
+
+// Every method on the runAdvanceSort input for the same k. Returns rows of
+// [method, k, ns, comparisons, assignments]; ns is the uninstrumented pass.
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runTopKBenchmark(JNIEnv *env, jobject, jint arraySize, jint k)
+{
+    vector<int> input = generateSortInput(arraySize);
+    vector<int> expected;
+
+    vector<jlong> report;
+    for (const TopKEngine &engine : topKEngines)
+    {
+        vector<int> counted;
+        SortMetrics metrics;
+        engine.select(input, k, counted, metrics);
+
+        vector<int> selected;
+        NoMetrics timed;
+        auto start = chrono::high_resolution_clock::now();
+        engine.selectTimed(input, k, selected, timed);
+        auto end = chrono::high_resolution_clock::now();
+
+        if (engine.method == TOPK_FULL_HEAP_SORT)
+            expected = selected;
+        else if (selected != expected || counted != expected)
+            LOGE("Top-k method %d disagrees with the full sort", engine.method);
+
+        report.push_back(engine.method);
+        report.push_back(selected.size());
+        report.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        report.push_back(metrics.comparison);
+        report.push_back(metrics.assigments);
+    }
+
+    jlongArray result = env->NewLongArray(report.size());
+    env->SetLongArrayRegion(result, 0, report.size(), report.data());
+    return result;
+}
@@ -0,0 +1,237 @@
+//
+// The bubble, heap, std::sort and LSD radix kernels on every element type of
+// elementTraits.hpp. Comparison sorts cost about the same per element at any
+// width while the radix passes grow with the key bytes, so ns per element
+// against the element size shows where each kind stops winning.
+//
+#include <jni.h>
+#include <vector>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <android/log.h>
+
+#include "../includes/sortingAlg.hpp"
+#include "../includes/elementTraits.hpp"
+#include "../includes/dataGenerator.hpp"
+
+#define LOG_TAG "TypedSort"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+using namespace std;
+
+// Floating point inputs get one special value (NaN of either sign, an
+// infinity or a signed zero) per SPECIAL_VALUE_PERIOD elements on average
+static const int SPECIAL_VALUE_PERIOD = 256;
+static const double FLOAT_INPUT_RANGE = 1e6;
+
+static const char *elementTypeNames[ELEMENT_TYPE_COUNT] = {
+        "int8",
+        "int16",
+        "int32",
+        "int64",
+        "float",
+        "double",
+        "pair<u64,u32>"
+};
+
+const char *getElementTypeName(int elementType)
+{
+    if (elementType < 0 || elementType >= ELEMENT_TYPE_COUNT)
+        return nullptr;
+    return elementTypeNames[elementType];
+}
+
+// Integers use the full range of the type, negative values included
+template <typename T>
+static T randomElement(Xoshiro256 &rng, int)
+{
+    return (T) rng.next();
+}
+
+template <typename T>
+static T randomFloatingPoint(Xoshiro256 &rng)
+{
+    if (rng.nextInRange(0, SPECIAL_VALUE_PERIOD - 1) == 0)
+    {
+        switch (rng.nextInRange(0, 5))
+        {
+            case 0: return numeric_limits<T>::quiet_NaN();
+            case 1: return -numeric_limits<T>::quiet_NaN();
+            case 2: return numeric_limits<T>::infinity();
+            case 3: return -numeric_limits<T>::infinity();
+            case 4: return (T) -0.0;
+            default: return (T) 0.0;
+        }
+    }
+    return (T) ((rng.nextDouble() * 2 - 1) * FLOAT_INPUT_RANGE);
+}
+
+template <>
+float randomElement<float>(Xoshiro256 &rng, int)
+{
+    return randomFloatingPoint<float>(rng);
+}
+
+template <>
+double randomElement<double>(Xoshiro256 &rng, int)
+{
+    return randomFloatingPoint<double>(rng);
+}
+
+// About four elements per key, so the payload decides the ties
+template <>
+KeyPayload randomElement<KeyPayload>(Xoshiro256 &rng, int n)
+{
+    return KeyPayload(rng.nextInRange(0, max(1, n / 4)), (uint32_t) rng.next());
+}
+
+template <typename T, typename Metrics>
+static void stdSortElements(Span<T> array, Metrics &metrics)
+{
+    sort(array.begin(), array.end(), [&metrics](const T &a, const T &b) {
+        metrics.comparison++;
+        return ElementTraits<T>::less(a, b);
+    });
+}
+
+template <typename T>
+static bool isSortedElements(const vector<T> &data)
+{
+    return is_sorted(data.begin(), data.end(), ElementTraits<T>::less);
+}
+
+static long long elapsedNs(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// Counting pass on a copy, then the uninstrumented pass on the input itself.
+// Fills [comparisons, assignments, counted ns, ns]; false for an engine
+// without a typed kernel.
+template <typename T>
+static bool runTypedEngine(int engineId, vector<T> &data, jlong *out)
+{
+    void (*counted)(Span<T>, SortMetrics&);
+    void (*timed)(Span<T>, NoMetrics&);
+    switch (engineId)
+    {
+        case SORT_BUBBLE:
+            counted = bubbleSort<T, SortMetrics>;
+            timed = bubbleSort<T, NoMetrics>;
+            break;
+        case SORT_HEAP:
+            counted = HeapSort<T, SortMetrics>;
+            timed = HeapSort<T, NoMetrics>;
+            break;
+        case SORT_STD:
+            counted = stdSortElements<T, SortMetrics>;
+            timed = stdSortElements<T, NoMetrics>;
+            break;
+        case SORT_LSD_RADIX_8:
+            counted = lsdRadixSortElements<T, SortMetrics>;
+            timed = lsdRadixSortElements<T, NoMetrics>;
+            break;
+        default:
+            return false;
+    }
+
+    vector<T> scratch = data;
+    SortMetrics metrics;
+    auto start = chrono::high_resolution_clock::now();
+    counted(scratch, metrics);
+    long long countedNs = elapsedNs(start);
+
+    NoMetrics noMetrics;
+    start = chrono::high_resolution_clock::now();
+    timed(data, noMetrics);
+    long long ns = elapsedNs(start);
+
+    if (!isSortedElements(scratch) || !isSortedElements(data))
+        LOGE("Engine %d left %d byte elements unsorted", engineId, (int) sizeof(T));
+
+    out[0] = metrics.comparison;
+    out[1] = metrics.assigments;
+    out[2] = countedNs;
+    out[3] = ns;
+    return true;
+}
+
+template <typename T>
+static bool benchmarkElementType(int engineId, int arraySize, jlong *out)
+{
+    vector<T> data(arraySize);
+    Xoshiro256 rng(12345);
+    for (T &value : data)
+        value = randomElement<T>(rng, arraySize);
+    return runTypedEngine(engineId, data, out);
+}
+
+// Element type names indexed by id
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_getElementTypeNames(JNIEnv *env, jobject)
+{
+    jclass stringClass = env->FindClass("java/lang/String");
+    jobjectArray names = env->NewObjectArray(ELEMENT_TYPE_COUNT, stringClass, NULL);
+    for (int t = 0; t < ELEMENT_TYPE_COUNT; t++)
+    {
+        jstring name = env->NewStringUTF(elementTypeNames[t]);
+        env->SetObjectArrayElement(names, t, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+// Sorts arraySize random elements of elementType with SORT_BUBBLE, SORT_HEAP,
+// SORT_STD or SORT_LSD_RADIX_8. Returns [engine id, element type, element
+// bytes, array size, comparisons, assignments, counted ns, ns]
+extern "C" JNIEXPORT jlongArray JNICALL
+Java_com_example_myapplication_testCpuWithSorting_runTypedSort(JNIEnv *env, jobject, jint engineId, jint elementType, jint arraySize)
+{
+    int n = max(0, (int) arraySize);
+    jlong report[8] = {engineId, elementType, 0, n, 0, 0, 0, 0};
+    bool ok;
+    switch (elementType)
+    {
+        case ELEMENT_INT8:
+            report[2] = sizeof(int8_t);
+            ok = benchmarkElementType<int8_t>(engineId, n, report + 4);
+            break;
+        case ELEMENT_INT16:
+            report[2] = sizeof(int16_t);
+            ok = benchmarkElementType<int16_t>(engineId, n, report + 4);
+            break;
+        case ELEMENT_INT32:
+            report[2] = sizeof(int32_t);
+            ok = benchmarkElementType<int32_t>(engineId, n, report + 4);
+            break;
+        case ELEMENT_INT64:
+            report[2] = sizeof(int64_t);
+            ok = benchmarkElementType<int64_t>(engineId, n, report + 4);
+            break;
+        case ELEMENT_FLOAT:
+            report[2] = sizeof(float);
+            ok = benchmarkElementType<float>(engineId, n, report + 4);
+            break;
+        case ELEMENT_DOUBLE:
+            report[2] = sizeof(double);
+            ok = benchmarkElementType<double>(engineId, n, report + 4);
+            break;
+        case ELEMENT_KEY_PAYLOAD:
+            report[2] = sizeof(KeyPayload);
+            ok = benchmarkElementType<KeyPayload>(engineId, n, report + 4);
+            break;
+        default:
+            LOGE("Unknown element type %d", elementType);
+            return NULL;
+    }
+    if (!ok)
+    {
+        LOGE("Sort engine %d has no typed kernel", engineId);
+        return NULL;
+    }
+
+    jlongArray result = env->NewLongArray(8);
+    env->SetLongArrayRegion(result, 0, 8, report);
+    return result;
+}
@@ -35,5 +35,20 @@ class MainActivity : AppCompatActivity() {
             val intent = Intent(this, OpenGLActivity::class.java)
             startActivity(intent)
         }
+        // Engine ids match SortEngineId (0 = bubble, 1 = heap). Bubble sort is quadratic,
+        // so it gets fewer bars to finish in reasonable time
+        binding.visualizeBubbleButton.setOnClickListener {
+            visualizeSort(0, 2_000)
+        }
+        binding.visualizeHeapButton.setOnClickListener {
+            visualizeSort(1, 100_000)
+        }
+    }
+
+    private fun visualizeSort(engineId: Int, elementCount: Int) {
+        val intent = Intent(this, OpenGLActivity::class.java)
+        intent.putExtra(OpenGLActivity.EXTRA_SORT_ENGINE, engineId)
+        intent.putExtra(OpenGLActivity.EXTRA_SORT_ELEMENTS, elementCount)
+        startActivity(intent)
     }
 }
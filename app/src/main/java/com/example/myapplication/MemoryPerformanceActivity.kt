@@ -10,6 +10,7 @@ import com.github.mikephil.charting.components.XAxis
 import com.github.mikephil.charting.data.Entry
 import com.github.mikephil.charting.data.LineData
 import com.github.mikephil.charting.data.LineDataSet
+import com.github.mikephil.charting.interfaces.datasets.ILineDataSet
 import kotlin.math.sqrt
 import android.widget.TableRow
 import android.widget.TextView
@@ -17,11 +18,17 @@ import android.view.Gravity
 import android.view.View
 
 data class BenchmarkResult(val n: Long, val timeBad: Double, val timeGood: Double)
+data class RecursiveResult(val n: Long, val timeIJK: Double, val timeTiled: Double,
+                           val timeRecursive: Double, val timeStrassen: Double)
+data class KernelResult(val label: String, val seconds: Double, val detail: String, val matches: Boolean)
 class MemoryPerformanceActivity : AppCompatActivity() {
 
     private lateinit var binding: ActivityMemoryPerformanceBinding
     private var cacheSizes: LongArray? = null
 
+    // We test sizes relative to the detected cache (e.g., 0.5x the size, 2.0x the size)
+    private val sizeMultipliers = listOf(0.1, 0.25, 0.5, 0.75, 1.0, 1.25,1.5,1.75, 2.0, 4.0)
+
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
         binding = ActivityMemoryPerformanceBinding.inflate(layoutInflater)
@@ -36,22 +43,34 @@ class MemoryPerformanceActivity : AppCompatActivity() {
         setupChart()
 
         binding.btnStart.setOnClickListener {
-            // 2. DECIDE WHICH CACHE TO TARGET
-            // Index 0 = L1, Index 1 = L2, Index 2 = L3
-            // We try to grab L3. If it's 0 (doesn't exist), we fall back to L2.
-            val l3Size = cacheSizes?.get(2) ?: 0L
-            val l2Size = cacheSizes?.get(1) ?: 0L
+            runFullBenchmark(targetCacheSize())
+        }
 
-            // Default to 2MB if everything fails so the app doesn't crash
-            val targetCache = if (l3Size > 0) l3Size else if (l2Size > 0) l2Size else 2 * 1024 * 1024L
+        binding.btnRecursive.setOnClickListener {
+            runRecursiveBenchmark(targetCacheSize())
+        }
 
-            runFullBenchmark(targetCache)
+        binding.btnKernels.setOnClickListener {
+            runKernelBenchmark(targetCacheSize())
         }
     }
 
+    // 2. DECIDE WHICH CACHE TO TARGET
+    private fun targetCacheSize(): Long {
+        // Index 0 = L1, Index 1 = L2, Index 2 = L3
+        // We try to grab L3. If it's 0 (doesn't exist), we fall back to L2.
+        val l3Size = cacheSizes?.get(2) ?: 0L
+        val l2Size = cacheSizes?.get(1) ?: 0L
+
+        // Default to 2MB if everything fails so the app doesn't crash
+        return if (l3Size > 0) l3Size else if (l2Size > 0) l2Size else 2 * 1024 * 1024L
+    }
+
     private fun runFullBenchmark(detectedCacheSize: Long) {
         binding.progressBar.visibility = View.VISIBLE
         binding.btnStart.isEnabled = false
+        binding.btnRecursive.isEnabled = false
+        binding.btnKernels.isEnabled = false
         binding.statusText.text = "Running Benchmark..."
 
         Thread {
@@ -59,15 +78,9 @@ class MemoryPerformanceActivity : AppCompatActivity() {
             val entriesIKJ = ArrayList<Entry>()
             val tableResults = ArrayList<BenchmarkResult>()
 
-            // We test sizes relative to the detected cache (e.g., 0.5x the size, 2.0x the size)
-            val sizeMultipliers = listOf(0.1, 0.25, 0.5, 0.75, 1.0, 1.25,1.5,1.75, 2.0, 4.0)
-
             for (multiplier in sizeMultipliers) {
                 val targetBytes = (detectedCacheSize * multiplier).toLong()
-
-                // Math: N = sqrt(Bytes / 24).
-                // 24 comes from: 3 matrices * 8 bytes (sizeof long)
-                val n = sqrt(targetBytes.toDouble() / 24.0).toLong()
+                val n = matrixDimensionFor(targetBytes)
 
                 runOnUiThread {
                     binding.statusText.text =
@@ -103,6 +116,8 @@ class MemoryPerformanceActivity : AppCompatActivity() {
             runOnUiThread {
                 updateChartData(entriesIJK, entriesIKJ)
                 binding.btnStart.isEnabled = true
+                binding.btnRecursive.isEnabled = true
+                binding.btnKernels.isEnabled = true
                 binding.statusText.text = "Done! Check the graph."
                 binding.progressBar.visibility = View.GONE
                 populateTable(tableResults)
@@ -177,10 +192,224 @@ class MemoryPerformanceActivity : AppCompatActivity() {
         binding.lineChart.invalidate() // Refresh
     }
 
+    // Math: N = sqrt(Bytes / 24).
+    // 24 comes from: 3 matrices * 8 bytes (sizeof long)
+    private fun matrixDimensionFor(targetBytes: Long): Long =
+        sqrt(targetBytes.toDouble() / 24.0).toLong()
+
+    // Naive, tiled, recursive and Strassen GEMM over the same sizes as the main sweep,
+    // to show where Strassen's fewer multiplications start to pay for its extra traffic
+    private fun runRecursiveBenchmark(detectedCacheSize: Long) {
+        binding.progressBar.visibility = View.VISIBLE
+        binding.btnStart.isEnabled = false
+        binding.btnRecursive.isEnabled = false
+        binding.btnKernels.isEnabled = false
+        binding.statusText.text = "Running Recursive Benchmark..."
+
+        Thread {
+            val series = List(4) { ArrayList<Entry>() }
+            val rows = ArrayList<RecursiveResult>()
+            var cutoff = 0
+            var allMatch = true
+
+            for (multiplier in sizeMultipliers) {
+                val n = matrixDimensionFor((detectedCacheSize * multiplier).toLong())
+                runOnUiThread {
+                    binding.statusText.text = "Recursive / Strassen: ${n}x${n}..."
+                }
+
+                // [IJK s, tiled s, recursive s, Strassen s, cutoff, match]
+                val result = runRecursiveMatrixBenchmark(Build.HARDWARE, Build.BOARD, n.toInt())
+                for (kernel in 0 until 4) {
+                    series[kernel].add(Entry(multiplier.toFloat(), result[kernel].toFloat()))
+                }
+                rows.add(RecursiveResult(n, result[0], result[1], result[2], result[3]))
+                cutoff = result[4].toInt()
+                allMatch = allMatch && result[5] == 1.0
+            }
+
+            runOnUiThread {
+                updateRecursiveChartData(series)
+                populateRecursiveTable(rows)
+                binding.btnStart.isEnabled = true
+                binding.btnRecursive.isEnabled = true
+                binding.btnKernels.isEnabled = true
+                binding.statusText.text = "Done! Strassen cutoff $cutoff" +
+                    if (allMatch) "" else "\nWARNING: a kernel disagreed with I-J-K"
+                binding.progressBar.visibility = View.GONE
+            }
+        }.start()
+    }
+
+    private fun populateRecursiveTable(results: List<RecursiveResult>) {
+        val colors = listOf(Color.RED, Color.parseColor("#1976D2"), Color.parseColor("#388E3C"),
+            Color.parseColor("#7B1FA2"))
+        for (res in results) {
+            val row = TableRow(this)
+            row.setPadding(0, 16, 0, 16)
+            row.addView(TextView(this).apply {
+                text = "${res.n} x ${res.n}"
+                setTextColor(Color.BLACK)
+            })
+            listOf(res.timeIJK, res.timeTiled, res.timeRecursive, res.timeStrassen).forEachIndexed { i, time ->
+                row.addView(TextView(this).apply {
+                    text = String.format("%.4f s", time)
+                    setTextColor(colors[i])
+                    gravity = Gravity.END
+                })
+            }
+            binding.recursiveTable.addView(row)
+        }
+    }
+
+    private fun updateRecursiveChartData(series: List<ArrayList<Entry>>) {
+        val labels = listOf("IJK", "Tiled", "Recursive", "Strassen")
+        val colors = listOf(Color.RED, Color.BLUE, Color.GREEN, Color.MAGENTA)
+        val dataSets: List<ILineDataSet> = series.mapIndexed { i, entries ->
+            LineDataSet(entries, labels[i]).apply {
+                color = colors[i]
+                setCircleColor(colors[i])
+                lineWidth = 2f
+                valueTextSize = 10f
+            }
+        }
+        binding.lineChart.data = LineData(dataSets)
+        binding.lineChart.invalidate()
+    }
+
+    // Tiled, packed micro-kernel and multi-threaded GEMM on one matrix twice the target
+    // cache, so every kernel streams from DRAM. Charts parallel speedup per core cluster
+    private fun runKernelBenchmark(detectedCacheSize: Long) {
+        binding.progressBar.visibility = View.VISIBLE
+        binding.btnStart.isEnabled = false
+        binding.btnRecursive.isEnabled = false
+        binding.btnKernels.isEnabled = false
+        binding.statusText.text = "Running Kernel Benchmark..."
+
+        Thread {
+            val n = matrixDimensionFor(detectedCacheSize * 2).toInt()
+            val rows = ArrayList<KernelResult>()
+            val speedups = ArrayList<ArrayList<Entry>>()
+
+            runOnUiThread { binding.statusText.text = "Tiled GEMM: ${n}x${n}..." }
+            // [IKJ s, tiled s, mc, kc, nc, match]
+            val tiled = runTiledMatrixBenchmark(Build.HARDWARE, Build.BOARD, n)
+            val tiledMatch = tiled[5] == 1.0
+            rows.add(KernelResult("I-K-J", tiled[0], "${n}x${n}", tiledMatch))
+            rows.add(KernelResult("Tiled", tiled[1],
+                "${tiled[2].toInt()}x${tiled[3].toInt()}x${tiled[4].toInt()}", tiledMatch))
+
+            runOnUiThread { binding.statusText.text = "Tile sweep: ${n}x${n}..." }
+            // [best row], then rows of [mc, kc, nc, seconds]
+            val sweep = runTileSweep(Build.HARDWARE, Build.BOARD, n)
+            val best = 1 + sweep[0].toInt() * 4
+            rows.add(KernelResult("Best tile", sweep[best + 3],
+                "${sweep[best].toInt()}x${sweep[best + 1].toInt()}x${sweep[best + 2].toInt()}", true))
+
+            runOnUiThread { binding.statusText.text = "Micro-kernels: ${n}x${n}..." }
+            // rows of [type, IJK s, packed s, IJK GOP/s, packed GOP/s, match]
+            val names = getMicroKernelNames()
+            val micro = runMicroKernelBenchmark(Build.HARDWARE, Build.BOARD, n)
+            for (row in micro.indices step 6) {
+                rows.add(KernelResult(names[micro[row].toInt()], micro[row + 2],
+                    String.format("%.2f vs %.2f GOP/s", micro[row + 4], micro[row + 3]), micro[row + 5] == 1.0))
+            }
+
+            // Cluster 0 all cores, 1 big, 2 little
+            val clusterNames = listOf("All cores", "Big", "Little")
+            val maxThreads = Runtime.getRuntime().availableProcessors()
+            for (cluster in clusterNames.indices) {
+                runOnUiThread {
+                    binding.statusText.text = "Parallel GEMM (${clusterNames[cluster]}): ${n}x${n}..."
+                }
+                // [CPUs], then rows of [threads, seconds, speedup, efficiency, match]
+                val parallel = runParallelMatrixBenchmark(Build.HARDWARE, Build.BOARD, n, maxThreads, cluster)
+                    ?: continue
+                val entries = ArrayList<Entry>()
+                for (row in 1 until parallel.size step 5) {
+                    val threads = parallel[row].toInt()
+                    entries.add(Entry(threads.toFloat(), parallel[row + 2].toFloat()))
+                    rows.add(KernelResult("${clusterNames[cluster]} x$threads", parallel[row + 1],
+                        String.format("%.2fx, %.0f%%", parallel[row + 2], parallel[row + 3] * 100),
+                        parallel[row + 4] == 1.0))
+                }
+                speedups.add(entries)
+            }
+
+            runOnUiThread {
+                updateSpeedupChartData(speedups, clusterNames)
+                populateKernelTable(rows)
+                binding.btnStart.isEnabled = true
+                binding.btnRecursive.isEnabled = true
+                binding.btnKernels.isEnabled = true
+                binding.statusText.text = "Done! Chart shows parallel speedup vs threads." +
+                    if (rows.all { it.matches }) "" else "\nWARNING: a kernel disagreed with I-K-J"
+                binding.progressBar.visibility = View.GONE
+            }
+        }.start()
+    }
+
+    private fun populateKernelTable(results: List<KernelResult>) {
+        for (res in results) {
+            val row = TableRow(this)
+            row.setPadding(0, 16, 0, 16)
+            row.addView(TextView(this).apply {
+                text = res.label
+                setTextColor(if (res.matches) Color.BLACK else Color.RED)
+            })
+            row.addView(TextView(this).apply {
+                text = String.format("%.4f s", res.seconds)
+                setTextColor(Color.parseColor("#1976D2"))
+                gravity = Gravity.END
+            })
+            row.addView(TextView(this).apply {
+                text = res.detail
+                setTextColor(Color.parseColor("#388E3C"))
+                gravity = Gravity.END
+            })
+            binding.kernelTable.addView(row)
+        }
+    }
+
+    private fun updateSpeedupChartData(series: List<ArrayList<Entry>>, labels: List<String>) {
+        val colors = listOf(Color.BLUE, Color.RED, Color.GREEN)
+        val dataSets: List<ILineDataSet> = series.mapIndexed { i, entries ->
+            LineDataSet(entries, labels[i]).apply {
+                color = colors[i]
+                setCircleColor(colors[i])
+                lineWidth = 2f
+                valueTextSize = 10f
+            }
+        }
+        binding.lineChart.data = LineData(dataSets)
+        binding.lineChart.invalidate()
+    }
+
     // 3. CORRECT JNI SIGNATURES
     // Matches your C++ code: getCacheSizeBytes(JNIEnv, obj, jstring, jstring)
     private external fun getCacheSizeBytes(hardware: String, board: String): LongArray?
+    // [IJK seconds, IKJ seconds, 1.0 if both produced the same C]
     private external fun runMatrixBenchmark(matrixDimension: Long): DoubleArray
+    // Same, with padding elements added to every row and rows packed when alignRows is false
+    private external fun runMatrixLayoutBenchmark(size: Int, padding: Int, alignRows: Boolean): DoubleArray
+    // IKJ against the cache-blocked kernel with tiles sized from this device's caches:
+    // [IKJ seconds, tiled seconds, mc, kc, nc, 1.0 if both produced the same C]
+    private external fun runTiledMatrixBenchmark(hardware: String, board: String, size: Int): DoubleArray
+    // [index of the fastest row], then rows of [mc, kc, nc, seconds]; row 0 is the cache-derived tile
+    private external fun runTileSweep(hardware: String, board: String, size: Int): DoubleArray
+    // Packed GEMM with SIMD micro-kernels against naive IJK, rows of [type, IJK seconds,
+    // packed seconds, IJK GOP/s, packed GOP/s, 1.0 if equal]; type 0 float32 8x8, 1 int32 4x4, 2 int64 4x4
+    private external fun runMicroKernelBenchmark(hardware: String, board: String, size: Int): DoubleArray
+    // Kernel names by type, e.g. "NEON 8x8 float32"
+    private external fun getMicroKernelNames(): Array<String>
+    // Parallel tiled GEMM on 1..maxThreads threads, cluster 0 all cores, 1 big, 2 little:
+    // [CPUs in the cluster], then rows of [threads, seconds, speedup, efficiency, 1.0 if equal];
+    // null when the cluster has no CPUs
+    private external fun runParallelMatrixBenchmark(hardware: String, board: String, size: Int,
+                                                    maxThreads: Int, cluster: Int): DoubleArray?
+    // [IJK seconds, tiled seconds, recursive seconds, Strassen seconds, tuned Strassen cutoff,
+    // 1.0 if all four produced the same C]
+    private external fun runRecursiveMatrixBenchmark(hardware: String, board: String, size: Int): DoubleArray
 
     companion object {
         init {
@@ -33,4 +33,13 @@ class MyGLSurfaceView @JvmOverloads constructor(
 
         Log.i("MyGLSurfaceView", "GLSurfaceView initialized successfully")
     }
+
+    // Animates a sort on elementCount bars in place of the model
+    fun visualizeSort(engineId: Int, elementCount: Int) {
+        queueEvent { renderer.startSortVisualization(engineId, elementCount) }
+    }
+
+    fun stopSortVisualization() {
+        renderer.stopSortVisualization()
+    }
 }
\ No newline at end of file
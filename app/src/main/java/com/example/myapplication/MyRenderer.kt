@@ -31,6 +31,18 @@ class MyGLRenderer(private val context: Context) : GLSurfaceView.Renderer {
     private external fun nativeOnSurfaceCreated()
     private external fun nativeOnSurfaceChanged(width: Int, height: Int)
     private external fun nativeOnDrawFrame()
+    private external fun nativeStartSortVisualization(engineId: Int, elementCount: Int)
+    private external fun nativeStopSortVisualization()
+
+    // GL thread only (GLSurfaceView.queueEvent). engineId is 0 (bubble sort) or 1 (heap sort)
+    fun startSortVisualization(engineId: Int, elementCount: Int) {
+        nativeStartSortVisualization(engineId, elementCount)
+    }
+
+    // Safe from any thread, the model is drawn again from the next frame
+    fun stopSortVisualization() {
+        nativeStopSortVisualization()
+    }
 
     override fun onSurfaceCreated(gl: GL10?, config: EGLConfig?) {
         Log.i(TAG, "onSurfaceCreated called")
@@ -6,6 +6,13 @@ import androidx.appcompat.app.AppCompatActivity
 
 class OpenGLActivity : AppCompatActivity() {
 
+    companion object {
+        // Sort engine id to animate instead of the model (0 = bubble, 1 = heap)
+        const val EXTRA_SORT_ENGINE = "sortEngine"
+        const val EXTRA_SORT_ELEMENTS = "sortElements"
+        private const val DEFAULT_SORT_ELEMENTS = 100_000
+    }
+
     private lateinit var glSurfaceView: MyGLSurfaceView
 
     override fun onCreate(savedInstanceState: Bundle?) {
@@ -18,6 +25,11 @@ class OpenGLActivity : AppCompatActivity() {
             glSurfaceView = MyGLSurfaceView(this)
             setContentView(glSurfaceView)
 
+            val sortEngine = intent.getIntExtra(EXTRA_SORT_ENGINE, -1)
+            if (sortEngine >= 0) {
+                glSurfaceView.visualizeSort(sortEngine, intent.getIntExtra(EXTRA_SORT_ELEMENTS, DEFAULT_SORT_ELEMENTS))
+            }
+
             Log.i("OpenGLActivity", "GLSurfaceView created and set")
         } catch (e: Exception) {
             Log.e("OpenGLActivity", "Failed to create GLSurfaceView: ${e.message}")
@@ -44,6 +56,9 @@ class OpenGLActivity : AppCompatActivity() {
 
     override fun onDestroy() {
         super.onDestroy()
+        if (::glSurfaceView.isInitialized) {
+            glSurfaceView.stopSortVisualization()
+        }
         Log.i("OpenGLActivity", "Activity destroyed")
     }
 }
\ No newline at end of file
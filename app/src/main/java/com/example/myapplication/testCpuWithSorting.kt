@@ -18,6 +18,11 @@ class testCpuWithSorting : AppCompatActivity() {
     private lateinit var binding: ActivityTestCpuBinding
     private val arraySize = listOf(1000, 2000, 3000, 4000, 5000, 6000, 7000, 8000, 9000, 10000, 15000, 20000)
     private val testsPerSize = 7
+    // Keys per container: a few KB (L1-resident) up to 30-120 MB (DRAM-resident)
+    private val containerSizes = listOf(1_000, 8_000, 64_000, 512_000, 4_000_000)
+    private val containerOperations = 10_000
+    // Graph vertices at ~76 bytes each: 30 KB (L1-resident) up to 76 MB (DRAM-resident)
+    private val queueVertexCounts = listOf(400, 4_000, 32_000, 256_000, 1_000_000)
 
     override fun onCreate(savedInstanceState: Bundle?) {
         super.onCreate(savedInstanceState)
@@ -34,6 +39,14 @@ class testCpuWithSorting : AppCompatActivity() {
         binding.startBenchmarkButton.setOnClickListener {
             runBenchmark()
         }
+
+        binding.orderedContainersButton.setOnClickListener {
+            runOrderedContainerSweep()
+        }
+
+        binding.priorityQueuesButton.setOnClickListener {
+            runPriorityQueueSweep()
+        }
     }
 
     private fun setUpChart(chart: LineChart, title: String, yAxis: String) {
@@ -77,6 +90,8 @@ class testCpuWithSorting : AppCompatActivity() {
         binding.progressBar.visibility = View.VISIBLE
         binding.resultsTextview.text = "Running..."
         binding.startBenchmarkButton.isEnabled = false
+        binding.orderedContainersButton.isEnabled = false
+        binding.priorityQueuesButton.isEnabled = false
 
         val bubbleResults = mutableListOf<AverageBenchmarkResult>()
         val heapResults = mutableListOf<AverageBenchmarkResult>()
@@ -102,10 +117,10 @@ class testCpuWithSorting : AppCompatActivity() {
                                     "Test: $test/$testsPerSize"
                     }
 
-                    val resultString = runAdvanceSort(size)
-                    val (bubbleResult, heapResult) = parseResults(resultString, size)
-                    bubbleTestResults.add(bubbleResult)
-                    heapTestResults.add(heapResult)
+                    val records = runAdvanceSort(size, 1)
+                    val (bubbleResult, heapResult) = parseResults(records)
+                    bubbleTestResults.addAll(bubbleResult)
+                    heapTestResults.addAll(heapResult)
 
                     delay(50)
                 }
@@ -123,6 +138,97 @@ class testCpuWithSorting : AppCompatActivity() {
                 displayGraphs(bubbleResults, heapResults)
                 binding.progressBar.visibility = View.GONE
                 binding.startBenchmarkButton.isEnabled = true
+                binding.orderedContainersButton.isEnabled = true
+                binding.priorityQueuesButton.isEnabled = true
+            }
+        }
+    }
+
+    // Replays the same mixed workload on every container from L1-resident to DRAM-resident sizes
+    private fun runOrderedContainerSweep() {
+        binding.progressBar.visibility = View.VISIBLE
+        binding.startBenchmarkButton.isEnabled = false
+        binding.orderedContainersButton.isEnabled = false
+        binding.priorityQueuesButton.isEnabled = false
+
+        GlobalScope.launch(Dispatchers.Default) {
+            val names = listOf("Sorted vec", "std::set", "B+tree", "Skiplist")
+            val sb = StringBuilder()
+            sb.append("ORDERED CONTAINERS ($containerOperations mixed ops)\n")
+            sb.append("════════════════════════════════════\n\n")
+
+            for (size in containerSizes) {
+                withContext(Dispatchers.Main) {
+                    binding.resultsTextview.text = "Running ordered containers...\n\nKeys: $size"
+                }
+                // Rows of [container, bytes, buildNs, replayNs, checksum]
+                val rows = runOrderedContainerBenchmark(size, containerOperations)
+                sb.append("$size keys\n")
+                sb.append("─────────────────────────────────\n")
+                sb.append("Container   KB       Build(ms) ns/op\n")
+                for (row in rows.indices step 5) {
+                    sb.append(String.format("%-11s %-8d %-9.1f %.0f%s\n",
+                        names[rows[row].toInt()],
+                        rows[row + 1] / 1024,
+                        rows[row + 2] / 1e6,
+                        rows[row + 3].toDouble() / containerOperations,
+                        if (rows[row + 4] == rows[4]) "" else "  checksum!"
+                    ))
+                }
+                sb.append("\n")
+            }
+
+            withContext(Dispatchers.Main) {
+                binding.resultsTextview.text = sb.toString()
+                binding.progressBar.visibility = View.GONE
+                binding.startBenchmarkButton.isEnabled = true
+                binding.orderedContainersButton.isEnabled = true
+                binding.priorityQueuesButton.isEnabled = true
+            }
+        }
+    }
+
+    // Dijkstra with every queue on graphs from L1-resident to DRAM-resident
+    private fun runPriorityQueueSweep() {
+        binding.progressBar.visibility = View.VISIBLE
+        binding.startBenchmarkButton.isEnabled = false
+        binding.orderedContainersButton.isEnabled = false
+        binding.priorityQueuesButton.isEnabled = false
+
+        GlobalScope.launch(Dispatchers.Default) {
+            val names = listOf("Binary", "4-ary", "Pairing", "Radix")
+            val sb = StringBuilder()
+            sb.append("PRIORITY QUEUES (Dijkstra)\n")
+            sb.append("════════════════════════════════════\n\n")
+
+            for (vertices in queueVertexCounts) {
+                withContext(Dispatchers.Main) {
+                    binding.resultsTextview.text = "Running priority queues...\n\nVertices: $vertices"
+                }
+                // [vertices, edges, graphBytes], then rows of [queue, ns, pushes, decreaseKeys,
+                // pops, opsPerSecond, queueBytes, distanceSum]
+                val report = runPriorityQueueBenchmark(vertices)
+                sb.append("$vertices vertices, ${report[1]} edges, ${report[2] / 1024} KB\n")
+                sb.append("─────────────────────────────────\n")
+                sb.append("Queue    Time(ms) Mops/s Queue KB\n")
+                for (row in 3 until report.size step 8) {
+                    sb.append(String.format("%-8s %-8.2f %-6.1f %d%s\n",
+                        names[report[row].toInt()],
+                        report[row + 1] / 1e6,
+                        report[row + 5] / 1e6,
+                        report[row + 6] / 1024,
+                        if (report[row + 7] == report[10]) "" else "  distances!"
+                    ))
+                }
+                sb.append("\n")
+            }
+
+            withContext(Dispatchers.Main) {
+                binding.resultsTextview.text = sb.toString()
+                binding.progressBar.visibility = View.GONE
+                binding.startBenchmarkButton.isEnabled = true
+                binding.orderedContainersButton.isEnabled = true
+                binding.priorityQueuesButton.isEnabled = true
             }
         }
     }
@@ -130,7 +236,7 @@ class testCpuWithSorting : AppCompatActivity() {
     private fun calculateAverage(results: List<BenchmarkResult>): AverageBenchmarkResult {
         val avgTime = results.map { it.timeMs }.average()
         val avgOps = results.map { it.operations }.average()
-        val stdDevTime = calculateStdDev(results.map { it.timeMs.toDouble() })
+        val stdDevTime = calculateStdDev(results.map { it.timeMs })
         val stdDevOps = calculateStdDev(results.map { it.operations.toDouble() })
 
         return AverageBenchmarkResult(
@@ -150,26 +256,25 @@ class testCpuWithSorting : AppCompatActivity() {
         return kotlin.math.sqrt(variance)
     }
 
-    private fun parseResults(result: String, arraySize: Int): Pair<BenchmarkResult, BenchmarkResult> {
-        val parts = result.split(';')
-        val bubbleParts = parts[0].split(',')
-        val heapParts = parts[1].split(',')
-
-        val bubbleResult = BenchmarkResult(
-            algorithm = "Bubble Sort",
-            arraySize = arraySize,
-            timeMs = bubbleParts[0].toLong(),
-            operations = bubbleParts[1].toLong()
-        )
-
-        val heapResult = BenchmarkResult(
-            algorithm = "Heap Sort",
-            arraySize = arraySize,
-            timeMs = heapParts[0].toLong(),
-            operations = heapParts[1].toLong()
-        )
+    // Splits the packed records from runAdvanceSort into one result per iteration
+    private fun parseResults(records: LongArray): Pair<List<BenchmarkResult>, List<BenchmarkResult>> {
+        val bubbleResults = parseRecord(records, 0, "Bubble Sort")
+        val heapOffset = RECORD_HEADER_SIZE + records[RECORD_ITERATIONS].toInt()
+        val heapResults = parseRecord(records, heapOffset, "Heap Sort")
+        return Pair(bubbleResults, heapResults)
+    }
 
-        return Pair(bubbleResult, heapResult)
+    private fun parseRecord(records: LongArray, offset: Int, algorithm: String): List<BenchmarkResult> {
+        val iterations = records[offset + RECORD_ITERATIONS].toInt()
+        return (0 until iterations).map { i ->
+            BenchmarkResult(
+                algorithm = algorithm,
+                arraySize = records[offset + RECORD_ARRAY_SIZE].toInt(),
+                timeNs = records[offset + RECORD_HEADER_SIZE + i],
+                comparisons = records[offset + RECORD_COMPARISONS],
+                assignments = records[offset + RECORD_ASSIGNMENTS]
+            )
+        }
     }
 
     private fun displayResults(bubbleResults: List<AverageBenchmarkResult>, heapResults: List<AverageBenchmarkResult>) {
@@ -347,9 +452,13 @@ class testCpuWithSorting : AppCompatActivity() {
     data class BenchmarkResult(
         val algorithm: String,
         val arraySize: Int,
-        val timeMs: Long,
-        val operations: Long
-    )
+        val timeNs: Long,
+        val comparisons: Long,
+        val assignments: Long
+    ) {
+        val timeMs: Double get() = timeNs / 1_000_000.0
+        val operations: Long get() = comparisons + assignments
+    }
 
     data class AverageBenchmarkResult(
         val algorithm: String,
@@ -361,9 +470,105 @@ class testCpuWithSorting : AppCompatActivity() {
         val testsRun: Int
     )
 
-    private external fun runAdvanceSort(arraySize: Int): String
+    // Packed records, see SortRecordField in sortingAlg.hpp
+    private external fun runAdvanceSort(arraySize: Int, iterations: Int): LongArray
+
+    // Sorts the same random data with java.util.Arrays.sort and natively in place.
+    // Returns [jvm ns, pin ns, native sort ns, release ns, isCopy]
+    fun compareJvmAndNativeSort(engineId: Int, size: Int): LongArray? {
+        val random = java.util.Random(12345)
+        val jvmData = IntArray(size) { random.nextInt(1000000) + 1 }
+        val nativeData = jvmData.copyOf()
+
+        val jvmStart = System.nanoTime()
+        java.util.Arrays.sort(jvmData)
+        val jvmNs = System.nanoTime() - jvmStart
+
+        val report = sortIntArrayInPlace(engineId, nativeData) ?: return null
+        if (!jvmData.contentEquals(nativeData)) return null
+        return longArrayOf(jvmNs, report[0], report[1], report[2], report[3])
+    }
+
+    // Sort engine registry, ids match SortEngineId in sortingAlg.hpp
+    external fun runSortEngine(engineId: Int, arraySize: Int, iterations: Int): LongArray?
+    external fun getSortEngineNames(): Array<String>
+
+    // Same record on a generated input, ids match InputDistribution in dataGenerator.hpp.
+    // parameter: swaps for nearly sorted, distinct values for few unique / Zipf, 0 = default
+    external fun runSortEngineOnInput(engineId: Int, arraySize: Int, distribution: Int, parameter: Int, iterations: Int): LongArray?
+    external fun getInputDistributionNames(): Array<String>
+    // [mt19937 ns, xoshiro ns] to fill arraySize ints
+    external fun runInputGenerationBenchmark(arraySize: Int): LongArray
+
+    // [threads, heapMs, parallelMs, speedup, per-thread ms...] for engine 12 or 13
+    external fun runParallelSort(engineId: Int, arraySize: Int): DoubleArray?
+
+    // [totalMs, leafMs] x {quick, merge} x {insertion, bitonic, odd-even} leaves
+    external fun runLeafKernelBenchmark(arraySize: Int): DoubleArray
+    external fun getSimdIsaName(): String
+
+    // [engineId, sortedNs, sortedComparisons, randomNs, randomComparisons] for
+    // bubble, branchless bubble, Floyd heap, branchless Floyd heap, branchy quicksort, BlockQuicksort
+    external fun runBranchMispredictionBenchmark(arraySize: Int): LongArray
+
+    // External sort of totalMegabytes of keys through files in directory (pass filesDir.absolutePath).
+    // [keys, runs, budgetBytes, genCpuMs, genIoMs, runIoMs, runCpuMs, mergeIoMs, mergeCpuMs, sorted]
+    external fun runExternalSort(directory: String, totalMegabytes: Int, useMmap: Boolean, engineId: Int): DoubleArray?
+
+    // Rows of [recordBytes, keyBits, layout (0 AoS, 1 SoA, 2 key/index), sortNs, gatherNs]
+    // for 16/32/64-byte records with 32- and 64-bit keys
+    external fun runRecordSortBenchmark(recordCount: Int): LongArray
+
+    // Element types by id: int8, int16, int32, int64, float, double, pair<u64,u32>.
+    // engineId is SORT_BUBBLE (0), SORT_HEAP (1), SORT_STD (6) or SORT_LSD_RADIX_8 (16).
+    // [engineId, elementType, elementBytes, arraySize, comparisons, assignments, countedNs, ns]
+    external fun getElementTypeNames(): Array<String>
+    external fun runTypedSort(engineId: Int, elementType: Int, arraySize: Int): LongArray?
+
+    // k smallest of the runAdvanceSort input. Rows of [method, k, ns, comparisons, assignments],
+    // method 0 full HeapSort, 1 full std::sort, 2 nth_element, 3 partial_sort, 4 bounded heap, 5 parallel
+    external fun runTopKBenchmark(arraySize: Int, k: Int): LongArray
+
+    // Adaptive front-end, cache sizes looked up from (Build.HARDWARE, Build.BOARD).
+    // Sorts data in place and returns "<engine name>: <reason>"
+    external fun adaptiveSortIntArray(hardware: String, board: String, data: IntArray): String?
+    // Rows of [distribution, picked engineId, adaptiveNs, insertionNs (-1 if skipped),
+    // radix8Ns, radix11Ns, pdqNs, parallelSampleNs] for every input distribution
+    external fun runAdaptiveSortBenchmark(hardware: String, board: String, arraySize: Int): LongArray
+
+    // [stringCount, arenaBytes, permille of neighbours split by the 8-byte prefix], then rows of
+    // [method, ns, comparisons, assignments]: 0 std::string, 1 handles without prefix,
+    // 2 handles with prefix, 3 multikey quicksort, 4 MSD radix
+    external fun runStringSortBenchmark(stringCount: Int, sharedPrefix: Int): LongArray
+
+    // Mixed lookup / insert / erase / range-scan replay. Rows of [container, bytes, buildNs,
+    // replayNs, checksum] for 0 sorted vector, 1 std::set, 2 B+tree, 3 skiplist.
+    // Sizes from ~1e3 (L1) to a few 1e6 keys (DRAM)
+    external fun runOrderedContainerBenchmark(size: Int, operations: Int): LongArray
+
+    // Dijkstra on a random graph (~76 bytes per vertex). [vertices, edges, graphBytes], then rows of
+    // [queue, ns, pushes, decreaseKeys, pops, opsPerSecond, queueBytes, distanceSum] for
+    // 0 binary heap, 1 4-ary heap, 2 pairing heap, 3 radix heap
+    external fun runPriorityQueueBenchmark(vertexCount: Int): LongArray
+
+    // Bitonic sort in OpenGL ES 3.0 fragment passes on an offscreen context, against HeapSort:
+    // [size, paddedSize, passes, uploadNs, sortNs, readbackNs, heapSortNs, matches], null without GLES 3
+    external fun runGpuBitonicSort(arraySize: Int): LongArray?
+
+    // In-place sorts of caller-owned data: [pinNs, sortNs, releaseNs, isCopy, operations].
+    // The ByteBuffer must be direct and use ByteOrder.nativeOrder().
+    external fun sortIntArrayInPlace(engineId: Int, data: IntArray): LongArray?
+    external fun sortDirectBuffer(engineId: Int, buffer: java.nio.ByteBuffer): LongArray?
 
     companion object {
+        // Record header layout, matches SortRecordField
+        const val RECORD_ARRAY_SIZE = 1
+        const val RECORD_COMPARISONS = 2
+        const val RECORD_ASSIGNMENTS = 3
+        const val RECORD_ITERATIONS = 4
+        const val RECORD_COUNTED_NS = 5
+        const val RECORD_HEADER_SIZE = 6
+
         init {
             System.loadLibrary("myapplication")
         }